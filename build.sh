@@ -0,0 +1,6 @@
+#!/bin/sh
+# The gcc build for Linux, against the system's SDL2, SDL2_ttf and SDL2_image.
+# assets/golden.txt's digests come from this build.
+mkdir -p bin
+cd bin
+gcc -O2 -g -std=gnu99 ../src/main.c -o hyphae $(pkg-config --cflags --libs sdl2 SDL2_ttf SDL2_image) -lm -lpthread
@@ -0,0 +1,250 @@
+//
+// Checkpoints of a run in progress.
+// Taking one only forks the graph, which shares its pages rather than copying
+// them; a writer thread puts the fork's counters and nodes (the frontier is the
+// nodes that haven't spawned yet) and where each generation ended on disk, then
+// lets the fork go. It writes
+// through a temporary file so a crash mid-write never leaves a broken
+// checkpoint behind. The grid and branch table aren't saved, since committing
+// the nodes again in order rebuilds them exactly. Node structs go out as they
+// are in memory, so a checkpoint only resumes on the same build.
+//
+
+#define CHECKPOINT_MAGIC 0x43505948 // "HYPC"
+#define CHECKPOINT_VERSION 4
+
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 node_size;
+    Uint32 seed;
+
+    Sint32 node_count;
+    Sint32 initial_point_count;
+    Sint32 active_point_count;
+    Sint32 max_nodes;
+    Sint32 next_branch;
+    Sint32 next_id;
+    Sint32 generation;
+    Sint32 window_x;
+    Sint32 window_y;
+    Uint32 do_iteration;
+    Uint32 starting_new;
+    float spawn_chance;
+
+    Uint64 random_state;
+
+    // What the collision pass has done so far, so a resumed run's totals cover the whole run.
+    Collision_Counts total_collisions;
+} Checkpoint_Header;
+
+typedef struct {
+    const char *path;
+    char *temporary_path;
+
+    // Generations between checkpoints, or 0 to only take them when asked.
+    int every;
+
+    SDL_Thread *thread;
+    SDL_sem *wake;
+    SDL_atomic_t quit;
+
+    // Set while the writer owns the snapshot; a checkpoint due meanwhile waits for the next generation.
+    SDL_atomic_t busy;
+    Graph snapshot;
+
+    // Only touched by the writer until it's been joined.
+    int written_count;
+    bool failed;
+
+    Uint64 longest_pause;
+} Checkpointer;
+
+bool checkpoint_write(Checkpointer *checkpointer)
+{
+    Graph *graph = &checkpointer->snapshot;
+
+    Checkpoint_Header header = {0};
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.node_size = sizeof(Node);
+    header.seed = graph->seed;
+    header.node_count = graph->node_count;
+    header.initial_point_count = graph->initial_point_count;
+    header.active_point_count = graph->active_point_count;
+    header.max_nodes = graph->max_nodes;
+    header.next_branch = graph->next_branch;
+    header.next_id = graph->next_id;
+    header.generation = graph->generation;
+    header.window_x = graph->window.x;
+    header.window_y = graph->window.y;
+    header.do_iteration = graph->do_iteration;
+    header.starting_new = graph->starting_new;
+    header.spawn_chance = graph->spawn_chance;
+    header.random_state = graph->random_state;
+    header.total_collisions = graph->total_collisions;
+
+    FILE *file = fopen(checkpointer->temporary_path, "wb");
+    if (!file) return false;
+
+    fwrite(&header, sizeof(Checkpoint_Header), 1, file);
+    for (int start = 0; start < graph->node_count; start += PAGE_ITEMS)
+    {
+        int count = graph->node_count - start < PAGE_ITEMS ? graph->node_count - start : PAGE_ITEMS;
+        fwrite(graph_node(graph, start), sizeof(Node), count, file);
+    }
+    fwrite(graph->generation_ends, sizeof(int), graph->generation, file);
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) return false;
+
+#ifdef _WIN32
+    return MoveFileExA(checkpointer->temporary_path, checkpointer->path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(checkpointer->temporary_path, checkpointer->path) == 0;
+#endif
+}
+
+int checkpoint_writer(void *data)
+{
+    Checkpointer *checkpointer = data;
+    bool named = false;
+
+    for (;;)
+    {
+        SDL_SemWait(checkpointer->wake);
+
+        // A snapshot taken just before quitting still gets written.
+        if (SDL_AtomicGet(&checkpointer->busy))
+        {
+            Trace *trace = checkpointer->snapshot.trace;
+            if (trace && !named) trace_name_thread(trace, "checkpoint");
+            named = true;
+
+            Uint64 start = SDL_GetPerformanceCounter();
+            if (checkpoint_write(checkpointer)) checkpointer->written_count += 1;
+            else checkpointer->failed = true;
+
+            if (trace) trace_span(trace, "checkpoint", "checkpoint", start, SDL_GetPerformanceCounter(), checkpointer->snapshot.generation, checkpointer->snapshot.node_count);
+
+            graph_free(&checkpointer->snapshot);
+
+            SDL_AtomicSet(&checkpointer->busy, 0);
+        }
+
+        if (SDL_AtomicGet(&checkpointer->quit)) break;
+    }
+
+    return 0;
+}
+
+void checkpoint_start(Checkpointer *checkpointer, const char *path, int every)
+{
+    memset(checkpointer, 0, sizeof(Checkpointer));
+    checkpointer->path = path;
+    checkpointer->every = every;
+
+    size_t length = strlen(path);
+    checkpointer->temporary_path = memory_alloc(MEMORY_SCRATCH, length + 5);
+    memcpy(checkpointer->temporary_path, path, length);
+    memcpy(checkpointer->temporary_path + length, ".tmp", 5);
+
+    checkpointer->wake = SDL_CreateSemaphore(0);
+    checkpointer->thread = SDL_CreateThread(checkpoint_writer, "checkpoint", checkpointer);
+}
+
+// Snapshot the graph for the writer. Returns false if the last one is still being written.
+bool checkpoint_take(Checkpointer *checkpointer, Graph *graph)
+{
+    if (SDL_AtomicGet(&checkpointer->busy)) return false;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    graph_fork(&checkpointer->snapshot, graph);
+
+    SDL_AtomicSet(&checkpointer->busy, 1);
+    SDL_SemPost(checkpointer->wake);
+
+    Uint64 pause = SDL_GetPerformanceCounter() - start;
+    if (pause > checkpointer->longest_pause) checkpointer->longest_pause = pause;
+
+    return true;
+}
+
+// Stop the writer once it's written anything outstanding. Returns false if any write failed.
+bool checkpoint_finish(Checkpointer *checkpointer)
+{
+    SDL_AtomicSet(&checkpointer->quit, 1);
+    SDL_SemPost(checkpointer->wake);
+    SDL_WaitThread(checkpointer->thread, NULL);
+
+    SDL_DestroySemaphore(checkpointer->wake);
+    memory_free(MEMORY_SCRATCH, checkpointer->temporary_path, strlen(checkpointer->path) + 5);
+
+    return !checkpointer->failed;
+}
+
+// Put graph back the way it was when the checkpoint was taken. graph has to have room for max_nodes.
+bool checkpoint_load(Graph *graph, const char *path, int max_nodes)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    Checkpoint_Header header;
+    bool ok = fread(&header, sizeof(Checkpoint_Header), 1, file) == 1 &&
+        header.magic == CHECKPOINT_MAGIC &&
+        header.version == CHECKPOINT_VERSION &&
+        header.node_size == sizeof(Node) &&
+        header.max_nodes > 0 && header.max_nodes <= max_nodes &&
+        header.node_count >= 0 && header.node_count <= header.max_nodes &&
+        header.generation >= 0 &&
+        header.spawn_chance >= 0 &&
+        header.window_x > 0 && header.window_y > 0;
+
+    Node *nodes = NULL;
+    int *generation_ends = NULL;
+    if (ok)
+    {
+        nodes = memory_alloc(MEMORY_SCRATCH, sizeof(Node) * (header.node_count + 1));
+        generation_ends = memory_alloc(MEMORY_NODES, sizeof(int) * (header.generation + 1));
+        ok = fread(nodes, sizeof(Node), header.node_count, file) == (size_t)header.node_count &&
+            fread(generation_ends, sizeof(int), header.generation, file) == (size_t)header.generation;
+    }
+    fclose(file);
+
+    if (!ok)
+    {
+        memory_free(MEMORY_SCRATCH, nodes, sizeof(Node) * (header.node_count + 1));
+        memory_free(MEMORY_NODES, generation_ends, sizeof(int) * (header.generation + 1));
+        return false;
+    }
+
+    graph->window = (Window){header.window_x, header.window_y};
+    graph_reset(graph);
+
+    // Committing in the original order rebuilds the grid cells and branch table exactly.
+    for (int i = 0; i < header.node_count; i += 1)
+    {
+        graph_commit(graph, nodes[i]);
+    }
+    memory_free(MEMORY_SCRATCH, nodes, sizeof(Node) * (header.node_count + 1));
+
+    graph->seed = header.seed;
+    graph->initial_point_count = header.initial_point_count;
+    graph->active_point_count = header.active_point_count;
+    graph->max_nodes = header.max_nodes;
+    graph->next_branch = header.next_branch;
+    graph->next_id = header.next_id;
+    memory_free(MEMORY_NODES, graph->generation_ends, sizeof(int) * graph->generation_capacity);
+    graph->generation_ends = generation_ends;
+    graph->generation_capacity = header.generation + 1;
+    graph->generation = header.generation;
+    graph->do_iteration = header.do_iteration;
+    graph->starting_new = header.starting_new;
+    graph->spawn_chance = header.spawn_chance;
+    graph->random_state = header.random_state;
+    graph->total_collisions = header.total_collisions;
+
+    return true;
+}
@@ -0,0 +1,263 @@
+//
+// Streaming deflate (RFC 1951) encoder.
+// LZ77 over a 32K sliding window with hash chains, written out with the fixed
+// Huffman codes. Not as tight as zlib, but small, dependency free, and it never
+// needs more than its own window in memory no matter how much goes through it.
+// Each run ends in a sync flush, so runs encoded independently (on different
+// threads, say) can be concatenated into one stream.
+//
+
+#define DEFLATE_WINDOW 32768
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_HASH_SIZE (1 << DEFLATE_HASH_BITS)
+#define DEFLATE_MAX_CHAIN 32
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+
+// Past this length the positions inside a match aren't worth hashing.
+#define DEFLATE_MAX_INSERT 32
+
+typedef struct {
+    Uint8 *bytes;
+    size_t count;
+    size_t capacity;
+} Byte_Buffer;
+
+typedef struct {
+    Byte_Buffer out;
+    Uint64 bits;
+    int bit_count;
+
+    // window[0] is absolute input position window_base.
+    Uint8 window[2 * DEFLATE_WINDOW];
+    Sint64 window_base;
+    int window_count;
+    Sint64 position;
+
+    Sint64 head[DEFLATE_HASH_SIZE];
+    Sint64 prev[DEFLATE_WINDOW];
+} Deflate;
+
+static const int deflate_length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const int deflate_length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const int deflate_distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const int deflate_distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+void byte_buffer_append(Byte_Buffer *buffer, const void *bytes, size_t count)
+{
+    if (buffer->count + count > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity : 65536;
+        while (capacity < buffer->count + count) capacity *= 2;
+
+        buffer->bytes = memory_realloc(MEMORY_SCRATCH, buffer->bytes, buffer->capacity, capacity);
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->bytes + buffer->count, bytes, count);
+    buffer->count += count;
+}
+
+void byte_buffer_free(Byte_Buffer *buffer)
+{
+    memory_free(MEMORY_SCRATCH, buffer->bytes, buffer->capacity);
+    *buffer = (Byte_Buffer){0};
+}
+
+void deflate_put_bits(Deflate *d, Uint32 value, int count)
+{
+    d->bits |= (Uint64)value << d->bit_count;
+    d->bit_count += count;
+
+    while (d->bit_count >= 8)
+    {
+        Uint8 byte = (Uint8)d->bits;
+        byte_buffer_append(&d->out, &byte, 1);
+        d->bits >>= 8;
+        d->bit_count -= 8;
+    }
+}
+
+// Huffman codes go out most significant bit first, everything else least significant bit first.
+void deflate_put_code(Deflate *d, Uint32 code, int length)
+{
+    Uint32 reversed = 0;
+    for (int i = 0; i < length; i += 1)
+    {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+
+    deflate_put_bits(d, reversed, length);
+}
+
+void deflate_put_symbol(Deflate *d, int symbol)
+{
+    if (symbol < 144)      deflate_put_code(d, 0x30 + symbol, 8);
+    else if (symbol < 256) deflate_put_code(d, 0x190 + symbol - 144, 9);
+    else if (symbol < 280) deflate_put_code(d, symbol - 256, 7);
+    else                   deflate_put_code(d, 0xC0 + symbol - 280, 8);
+}
+
+void deflate_put_match(Deflate *d, int length, int distance)
+{
+    int code = 28;
+    while (deflate_length_base[code] > length) code -= 1;
+    deflate_put_symbol(d, 257 + code);
+    deflate_put_bits(d, length - deflate_length_base[code], deflate_length_extra[code]);
+
+    code = 29;
+    while (deflate_distance_base[code] > distance) code -= 1;
+    deflate_put_code(d, code, 5);
+    deflate_put_bits(d, distance - deflate_distance_base[code], deflate_distance_extra[code]);
+}
+
+void deflate_begin_block(Deflate *d)
+{
+    // BFINAL = 0, BTYPE = 01 (fixed Huffman codes).
+    deflate_put_bits(d, 0, 1);
+    deflate_put_bits(d, 1, 2);
+}
+
+// Start a new run. The output buffer is emptied but kept, so d must start out zeroed.
+void deflate_init(Deflate *d)
+{
+    d->out.count = 0;
+    d->bits = 0;
+    d->bit_count = 0;
+    d->window_base = 0;
+    d->window_count = 0;
+    d->position = 0;
+
+    for (int i = 0; i < DEFLATE_HASH_SIZE; i += 1) d->head[i] = -1;
+    for (int i = 0; i < DEFLATE_WINDOW; i += 1) d->prev[i] = -1;
+
+    deflate_begin_block(d);
+}
+
+int deflate_hash(const Uint8 *p)
+{
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (DEFLATE_HASH_SIZE - 1);
+}
+
+void deflate_insert(Deflate *d, Sint64 position)
+{
+    int hash = deflate_hash(&d->window[position - d->window_base]);
+    d->prev[position & (DEFLATE_WINDOW - 1)] = d->head[hash];
+    d->head[hash] = position;
+}
+
+// Compress everything in the window that hasn't been compressed yet.
+void deflate_compress_window(Deflate *d)
+{
+    Sint64 end = d->window_base + d->window_count;
+
+    while (d->position < end)
+    {
+        Uint8 *current = &d->window[d->position - d->window_base];
+        int available = (int)(end - d->position);
+        int best_length = 0;
+        int best_distance = 0;
+
+        if (available >= DEFLATE_MIN_MATCH)
+        {
+            int max_length = available < DEFLATE_MAX_MATCH ? available : DEFLATE_MAX_MATCH;
+
+            Sint64 candidate = d->head[deflate_hash(current)];
+            for (int chain = 0; chain < DEFLATE_MAX_CHAIN && candidate >= d->window_base; chain += 1)
+            {
+                int distance = (int)(d->position - candidate);
+                if (distance > DEFLATE_WINDOW) break;
+
+                Uint8 *match = &d->window[candidate - d->window_base];
+                int length = 0;
+                while (length < max_length && match[length] == current[length]) length += 1;
+
+                if (length > best_length)
+                {
+                    best_length = length;
+                    best_distance = distance;
+                    if (length == max_length) break;
+                }
+
+                // Slots get reused as the window slides, so a chain that goes forwards has gone stale.
+                Sint64 next = d->prev[candidate & (DEFLATE_WINDOW - 1)];
+                if (next >= candidate) break;
+                candidate = next;
+            }
+
+            deflate_insert(d, d->position);
+        }
+
+        if (best_length >= DEFLATE_MIN_MATCH)
+        {
+            deflate_put_match(d, best_length, best_distance);
+
+            if (best_length <= DEFLATE_MAX_INSERT)
+            {
+                for (int i = 1; i < best_length && d->position + i + DEFLATE_MIN_MATCH <= end; i += 1)
+                {
+                    deflate_insert(d, d->position + i);
+                }
+            }
+
+            d->position += best_length;
+        }
+        else
+        {
+            deflate_put_symbol(d, *current);
+            d->position += 1;
+        }
+    }
+}
+
+void deflate_write(Deflate *d, const Uint8 *data, size_t size)
+{
+    while (size > 0)
+    {
+        // Keep the last 32K around as history and make room after it.
+        if (d->window_count == 2 * DEFLATE_WINDOW)
+        {
+            memmove(d->window, d->window + DEFLATE_WINDOW, DEFLATE_WINDOW);
+            d->window_base += DEFLATE_WINDOW;
+            d->window_count = DEFLATE_WINDOW;
+        }
+
+        size_t count = 2 * DEFLATE_WINDOW - d->window_count;
+        if (count > size) count = size;
+
+        memcpy(d->window + d->window_count, data, count);
+        d->window_count += (int)count;
+        data += count;
+        size -= count;
+
+        deflate_compress_window(d);
+    }
+}
+
+// End the run: close the block and byte-align the output with an empty stored block.
+// Nothing in a later run refers back into this one.
+void deflate_sync(Deflate *d)
+{
+    deflate_put_symbol(d, 256);
+
+    // BFINAL = 0, BTYPE = 00, then LEN = 0 and NLEN = 0xFFFF once aligned.
+    deflate_put_bits(d, 0, 3);
+    if (d->bit_count > 0) deflate_put_bits(d, 0, 8 - d->bit_count);
+    deflate_put_bits(d, 0x0000, 16);
+    deflate_put_bits(d, 0xFFFF, 16);
+}
+
+// Bytes that end a stream of synced runs: a final fixed-code block holding only its end code.
+static const Uint8 deflate_final_block[2] = {0x03, 0x00};
@@ -1,43 +1,72 @@
-
-typedef struct {
-    vec2 center;
-    int radius;
-} Circle;
-
-bool do_circles_collide(Circle a, Circle b)
-{
-    float dx = (a.center.x - b.center.x); 
-    float dy = (a.center.y - b.center.y);
-    float distance_between_a_and_b = sqrt((dx*dx) + (dy*dy));
-    return (distance_between_a_and_b < a.radius + b.radius);
-}
-
-void draw_circle(SDL_Renderer *renderer, Circle circle, SDL_Color color)
-{
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    for (int w = 0; w < circle.radius * 2; w += 1)
-    {
-        for (int h = 0; h < circle.radius * 2; h += 1)
-        {
-            int dx = circle.radius - w;
-            int dy = circle.radius - h;
-            if ((dx*dx + dy*dy) <= (circle.radius * circle.radius))
-            {
-                SDL_RenderDrawPoint(renderer, circle.center.x + dx, circle.center.y + dy);
-            }
-        }
-    }
-}
-
-void draw_text(SDL_Renderer *renderer, int x, int y, char *string, TTF_Font *font, SDL_Color font_color) {
-    SDL_Surface *surface = TTF_RenderText_Blended(font, string, font_color);
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-    int x_from_texture, y_from_texture;
-    SDL_QueryTexture(texture, NULL, NULL, &x_from_texture, &y_from_texture);
-    SDL_Rect rect = {x, y, x_from_texture, y_from_texture};
-
-    SDL_RenderCopy(renderer, texture, NULL, &rect);
-
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
-}
+
+typedef struct {
+    vec2 center;
+    int radius;
+} Circle;
+
+bool do_circles_collide(Circle a, Circle b)
+{
+    float dx = (a.center.x - b.center.x); 
+    float dy = (a.center.y - b.center.y);
+    float distance_between_a_and_b = sqrt((dx*dx) + (dy*dy));
+    return (distance_between_a_and_b < a.radius + b.radius);
+}
+
+#define DRAW_CIRCLE_BATCH 64
+
+// Filled circle as a rect per row, handed over DRAW_CIRCLE_BATCH rows at a time. Covers the pixels
+// within radius of the center, bar the ones exactly radius to the left of it or above it.
+void draw_circle(SDL_Renderer *renderer, Circle circle, SDL_Color color)
+{
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+
+    SDL_Rect rows[DRAW_CIRCLE_BATCH];
+    int row_count = 0;
+    for (int dy = circle.radius; dy > -circle.radius; dy -= 1)
+    {
+        // The widest dx with dx*dx + dy*dy inside, in whole pixels.
+        int squared = circle.radius * circle.radius - dy * dy;
+        int half_width = (int)sqrt(squared);
+        while (half_width * half_width > squared) half_width -= 1;
+        while ((half_width + 1) * (half_width + 1) <= squared) half_width += 1;
+        int left = -half_width > 1 - circle.radius ? -half_width : 1 - circle.radius;
+
+        int x0 = circle.center.x + left;
+        int x1 = circle.center.x + half_width;
+        rows[row_count] = (SDL_Rect){x0, circle.center.y + dy, x1 - x0 + 1, 1};
+        row_count += 1;
+
+        if (row_count == DRAW_CIRCLE_BATCH)
+        {
+            SDL_RenderFillRects(renderer, rows, row_count);
+            row_count = 0;
+        }
+    }
+
+    if (row_count > 0) SDL_RenderFillRects(renderer, rows, row_count);
+}
+
+// Filled disc at any size, drawn as one horizontal span per row.
+// Discs smaller than a pixel collapse to a single point.
+void draw_disc(SDL_Renderer *renderer, vec2 center, float radius, SDL_Color color)
+{
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+
+    if (radius < 1)
+    {
+        SDL_RenderDrawPoint(renderer, center.x, center.y);
+        return;
+    }
+
+    int top = (int)(center.y - radius);
+    int bottom = (int)(center.y + radius);
+    for (int y = top; y <= bottom; y += 1)
+    {
+        float dy = y - center.y;
+        float squared = radius * radius - dy * dy;
+        if (squared < 0) continue;
+
+        float half_width = sqrt(squared);
+        SDL_RenderDrawLine(renderer, (int)(center.x - half_width), y, (int)(center.x + half_width), y);
+    }
+}
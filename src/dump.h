@@ -0,0 +1,335 @@
+//
+// Binary node dump.
+// A finished graph written out a column at a time, little-endian, so a loader can
+// map the file and use the columns where they lie without parsing anything or
+// building Node structs. The layout is a Dump_Header followed by the columns,
+// each starting on an 8-byte boundary at the offset the header gives:
+//
+//   x, y, radius     float[node_count]
+//   branch, parent   Sint32[node_count]   (parent is -1 for the initial points)
+//   color            Uint32[node_count]   index into the palette
+//   palette          Uint32[palette_count] r | g << 8 | b << 16 | a << 24
+//
+
+#define DUMP_MAGIC 0x48505948 // "HYPH"
+#define DUMP_VERSION 1
+
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 header_size;
+    Uint32 node_count;
+    Uint32 palette_count;
+    Uint32 seed;
+    Sint32 window_x;
+    Sint32 window_y;
+    Sint32 initial_point_count;
+    Sint32 max_nodes;
+
+    Uint64 x_offset;
+    Uint64 y_offset;
+    Uint64 radius_offset;
+    Uint64 branch_offset;
+    Uint64 parent_offset;
+    Uint64 color_offset;
+    Uint64 palette_offset;
+    Uint64 file_size;
+} Dump_Header;
+
+typedef struct {
+    const Dump_Header *header;
+    const float *x;
+    const float *y;
+    const float *radius;
+    const Sint32 *branch;
+    const Sint32 *parent;
+    const Uint32 *color;
+    const Uint32 *palette;
+
+    // Node indices bucketed by grid row, so a band of rows can find its nodes.
+    int rows;
+    int *row_start;
+    int *row_nodes;
+
+    const Uint8 *base;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} Node_Dump;
+
+Uint32 dump_pack_color(SDL_Color color)
+{
+    return color.r | (color.g << 8) | (color.b << 16) | ((Uint32)color.a << 24);
+}
+
+SDL_Color dump_unpack_color(Uint32 packed)
+{
+    return (SDL_Color){packed & 0xFF, (packed >> 8) & 0xFF, (packed >> 16) & 0xFF, packed >> 24};
+}
+
+Uint64 dump_align(Uint64 offset)
+{
+    return (offset + 7) & ~(Uint64)7;
+}
+
+// Write one little-endian 32-bit value per node for the given column, then pad to 8 bytes.
+void dump_write_column(FILE *file, Graph *graph, int column, Uint32 *color_index)
+{
+    Uint32 buffer[4096];
+    int buffered = 0;
+
+    for (int i = 0; i < graph->node_count; i += 1)
+    {
+        Node *node = graph_node(graph, i);
+        Uint32 value = 0;
+
+        switch (column)
+        {
+            case 0: { float f = node->circle.center.x; memcpy(&value, &f, 4); } break;
+            case 1: { float f = node->circle.center.y; memcpy(&value, &f, 4); } break;
+            case 2: { float f = (float)node->circle.radius; memcpy(&value, &f, 4); } break;
+            case 3: value = (Uint32)node->branch; break;
+            case 4: value = (Uint32)node->parent; break;
+            case 5: value = color_index[i]; break;
+        }
+
+        buffer[buffered] = SDL_SwapLE32(value);
+        buffered += 1;
+
+        if (buffered == 4096 || i == graph->node_count - 1)
+        {
+            fwrite(buffer, 4, buffered, file);
+            buffered = 0;
+        }
+    }
+
+    if (graph->node_count % 2) fwrite("\0\0\0\0", 1, 4, file);
+}
+
+bool dump_write(Graph *graph, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    // Every node in a branch shares a color, so there are at most as many colors as branches.
+    // palette_lookup maps hash slots to palette entries; palette[0] is a sentinel that never matches.
+    int lookup_size = 16;
+    while (lookup_size < graph->next_branch * 2 + 2) lookup_size *= 2;
+    int lookup_mask = lookup_size - 1;
+
+    Uint32 *palette_lookup = memory_calloc(MEMORY_SCRATCH, lookup_size, sizeof(Uint32));
+    Uint32 *palette = memory_alloc(MEMORY_SCRATCH, sizeof(Uint32) * (lookup_size + 1));
+    Uint32 *color_index = memory_alloc(MEMORY_SCRATCH, sizeof(Uint32) * (graph->node_count + 1));
+    palette[0] = 0; // Alpha 0, which no node has.
+    int palette_count = 1;
+
+    for (int i = 0; i < graph->node_count; i += 1)
+    {
+        // Open addressing; the table is at least twice the palette, so there's always an empty slot.
+        Uint32 packed = dump_pack_color(graph_node(graph, i)->color);
+        int slot = (packed * 2654435761u) & lookup_mask;
+        while (palette_lookup[slot] && palette[palette_lookup[slot]] != packed) slot = (slot + 1) & lookup_mask;
+
+        if (!palette_lookup[slot])
+        {
+            palette[palette_count] = packed;
+            palette_lookup[slot] = palette_count;
+            palette_count += 1;
+        }
+        color_index[i] = palette_lookup[slot];
+    }
+
+    Uint64 column_size = dump_align((Uint64)graph->node_count * 4);
+
+    Dump_Header header = {0};
+    header.magic = SDL_SwapLE32(DUMP_MAGIC);
+    header.version = SDL_SwapLE32(DUMP_VERSION);
+    header.header_size = SDL_SwapLE32(sizeof(Dump_Header));
+    header.node_count = SDL_SwapLE32(graph->node_count);
+    header.palette_count = SDL_SwapLE32(palette_count);
+    header.seed = SDL_SwapLE32(graph->seed);
+    header.window_x = SDL_SwapLE32(graph->window.x);
+    header.window_y = SDL_SwapLE32(graph->window.y);
+    header.initial_point_count = SDL_SwapLE32(graph->initial_point_count);
+    header.max_nodes = SDL_SwapLE32(graph->max_nodes);
+
+    Uint64 offset = dump_align(sizeof(Dump_Header));
+    header.x_offset = SDL_SwapLE64(offset);      offset += column_size;
+    header.y_offset = SDL_SwapLE64(offset);      offset += column_size;
+    header.radius_offset = SDL_SwapLE64(offset); offset += column_size;
+    header.branch_offset = SDL_SwapLE64(offset); offset += column_size;
+    header.parent_offset = SDL_SwapLE64(offset); offset += column_size;
+    header.color_offset = SDL_SwapLE64(offset);  offset += column_size;
+    header.palette_offset = SDL_SwapLE64(offset); offset += dump_align((Uint64)palette_count * 4);
+    header.file_size = SDL_SwapLE64(offset);
+
+    fwrite(&header, sizeof(Dump_Header), 1, file);
+    for (int column = 0; column < 6; column += 1)
+    {
+        dump_write_column(file, graph, column, color_index);
+    }
+
+    for (int i = 0; i < palette_count; i += 1)
+    {
+        Uint32 value = SDL_SwapLE32(palette[i]);
+        fwrite(&value, 4, 1, file);
+    }
+    if (palette_count % 2) fwrite("\0\0\0\0", 1, 4, file);
+
+    memory_free(MEMORY_SCRATCH, color_index, sizeof(Uint32) * (graph->node_count + 1));
+    memory_free(MEMORY_SCRATCH, palette, sizeof(Uint32) * (lookup_size + 1));
+    memory_free(MEMORY_SCRATCH, palette_lookup, sizeof(Uint32) * lookup_size);
+
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+void dump_close(Node_Dump *dump)
+{
+    // The row index is only there if the header was good enough to size it.
+    if (dump->row_start) memory_free(MEMORY_GRID, dump->row_start, sizeof(int) * (dump->rows + 1));
+    if (dump->row_nodes) memory_free(MEMORY_GRID, dump->row_nodes, sizeof(int) * (dump->header->node_count + 1));
+
+#ifdef _WIN32
+    if (dump->base) UnmapViewOfFile(dump->base);
+    if (dump->mapping) CloseHandle(dump->mapping);
+    if (dump->file && dump->file != INVALID_HANDLE_VALUE) CloseHandle(dump->file);
+#else
+    if (dump->base) munmap((void *)dump->base, dump->size);
+#endif
+
+    memset(dump, 0, sizeof(Node_Dump));
+}
+
+bool dump_column_fits(Node_Dump *dump, Uint64 offset, Uint64 count)
+{
+    return offset % 8 == 0 && offset <= dump->size && count * 4 <= dump->size - offset;
+}
+
+bool dump_open(Node_Dump *dump, const char *path)
+{
+    memset(dump, 0, sizeof(Node_Dump));
+
+    // The columns are used in place, so they have to already be in this machine's byte order.
+    if (SDL_BYTEORDER != SDL_LIL_ENDIAN) return false;
+
+#ifdef _WIN32
+    dump->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (dump->file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(dump->file, &size);
+    dump->size = (size_t)size.QuadPart;
+
+    dump->mapping = CreateFileMappingA(dump->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (dump->mapping) dump->base = MapViewOfFile(dump->mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat status;
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+    {
+        dump->size = (size_t)status.st_size;
+        void *base = mmap(NULL, dump->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base != MAP_FAILED) dump->base = base;
+    }
+    close(fd);
+#endif
+
+    if (!dump->base || dump->size < sizeof(Dump_Header))
+    {
+        dump_close(dump);
+        return false;
+    }
+
+    const Dump_Header *header = (const Dump_Header *)dump->base;
+    Uint64 node_count = header->node_count;
+    bool valid = header->magic == DUMP_MAGIC &&
+        header->version == DUMP_VERSION &&
+        header->header_size >= sizeof(Dump_Header) &&
+        header->file_size <= dump->size &&
+        header->palette_count > 0 &&
+        header->window_x > 0 && header->window_y > 0 &&
+        dump_column_fits(dump, header->x_offset, node_count) &&
+        dump_column_fits(dump, header->y_offset, node_count) &&
+        dump_column_fits(dump, header->radius_offset, node_count) &&
+        dump_column_fits(dump, header->branch_offset, node_count) &&
+        dump_column_fits(dump, header->parent_offset, node_count) &&
+        dump_column_fits(dump, header->color_offset, node_count) &&
+        dump_column_fits(dump, header->palette_offset, header->palette_count);
+
+    if (!valid)
+    {
+        dump_close(dump);
+        return false;
+    }
+
+    dump->header = header;
+    dump->x = (const float *)(dump->base + header->x_offset);
+    dump->y = (const float *)(dump->base + header->y_offset);
+    dump->radius = (const float *)(dump->base + header->radius_offset);
+    dump->branch = (const Sint32 *)(dump->base + header->branch_offset);
+    dump->parent = (const Sint32 *)(dump->base + header->parent_offset);
+    dump->color = (const Uint32 *)(dump->base + header->color_offset);
+    dump->palette = (const Uint32 *)(dump->base + header->palette_offset);
+
+    return true;
+}
+
+// Bucket node indices by grid row with a counting sort, which leaves each row in commit order.
+// Also rejects the dump if any color points outside the palette, since that's about to be read.
+bool dump_index_rows(Node_Dump *dump)
+{
+    int node_count = dump->header->node_count;
+
+    dump->rows = dump->header->window_y / COLLISION_GRID_Y + 1;
+    if (dump->rows < 1) dump->rows = 1;
+    dump->row_start = memory_calloc(MEMORY_GRID, dump->rows + 1, sizeof(int));
+    dump->row_nodes = memory_alloc(MEMORY_GRID, sizeof(int) * (node_count + 1));
+
+    for (int i = 0; i < node_count; i += 1)
+    {
+        if (dump->color[i] >= dump->header->palette_count) return false;
+        dump->row_start[grid_clamp((int)(dump->y[i] / COLLISION_GRID_Y), dump->rows) + 1] += 1;
+    }
+    for (int row = 0; row < dump->rows; row += 1)
+    {
+        dump->row_start[row + 1] += dump->row_start[row];
+    }
+
+    int *fill = memory_alloc(MEMORY_SCRATCH, sizeof(int) * dump->rows);
+    memcpy(fill, dump->row_start, sizeof(int) * dump->rows);
+    for (int i = 0; i < node_count; i += 1)
+    {
+        int row = grid_clamp((int)(dump->y[i] / COLLISION_GRID_Y), dump->rows);
+        dump->row_nodes[fill[row]] = i;
+        fill[row] += 1;
+    }
+    memory_free(MEMORY_SCRATCH, fill, sizeof(int) * dump->rows);
+
+    return true;
+}
+
+// Like grid_gather, over whole rows [row0, row1].
+int dump_gather_rows(Node_Dump *dump, int row0, int row1, int **indices, int *capacity)
+{
+    row0 = grid_clamp(row0, dump->rows);
+    row1 = grid_clamp(row1, dump->rows);
+
+    int first = dump->row_start[row0];
+    int count = dump->row_start[row1 + 1] - first;
+    if (count > *capacity)
+    {
+        *indices = memory_realloc(MEMORY_SCRATCH, *indices, sizeof(int) * *capacity, sizeof(int) * count * 2);
+        *capacity = count * 2;
+    }
+
+    memcpy(*indices, dump->row_nodes + first, sizeof(int) * count);
+    qsort(*indices, count, sizeof(int), index_compare);
+
+    return count;
+}
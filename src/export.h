@@ -0,0 +1,261 @@
+//
+// Headless PNG export.
+// The graph is rasterized at any scale a band of rows at a time. Worker threads
+// each take the next band, rasterize it and encode it as a PNG strip, and the
+// calling thread writes the strips out in order. Only a couple of bands per
+// worker are ever in flight, however big the image is. Each band only looks at
+// the grid rows its world rows fall in. The nodes come either from a graph or
+// straight from the columns of a mapped dump.
+//
+
+#define EXPORT_BAND_HEIGHT 64
+
+// Same shape as draw_disc, clipped to the band's rows.
+void raster_disc(Uint8 *band, int width, int band_y, int band_height, vec2 center, float radius, SDL_Color color)
+{
+    int top = (int)(center.y - radius);
+    int bottom = (int)(center.y + radius);
+    if (radius < 1) top = bottom = (int)center.y;
+
+    if (top < band_y) top = band_y;
+    if (bottom > band_y + band_height - 1) bottom = band_y + band_height - 1;
+
+    for (int y = top; y <= bottom; y += 1)
+    {
+        int left = (int)center.x;
+        int right = (int)center.x;
+
+        if (radius >= 1)
+        {
+            float dy = y - center.y;
+            float squared = radius * radius - dy * dy;
+            if (squared < 0) continue;
+
+            float half_width = sqrt(squared);
+            left = (int)(center.x - half_width);
+            right = (int)(center.x + half_width);
+        }
+
+        if (left < 0) left = 0;
+        if (right > width - 1) right = width - 1;
+
+        Uint8 *pixel = band + ((size_t)(y - band_y) * width + left) * 3;
+        for (int x = left; x <= right; x += 1)
+        {
+            pixel[0] = color.r;
+            pixel[1] = color.g;
+            pixel[2] = color.b;
+            pixel += 3;
+        }
+    }
+}
+
+// Exactly one of graph and dump is set.
+typedef struct {
+    Graph *graph;
+    Node_Dump *dump;
+    Window window;
+
+    // Where to put a span per band, if anywhere.
+    Trace *trace;
+
+    // If set, every worker counts its rastering and encoding and adds it in here.
+    Perf_Counters *perf;
+} Export_Source;
+
+// Where export workers' counts go in a Perf_Counters, after the Phases.
+#define EXPORT_PERF_RASTER PHASE_COUNT
+#define EXPORT_PERF_ENCODE (PHASE_COUNT + 1)
+#define EXPORT_PERF_WAITING (PHASE_COUNT + 2)
+
+// Rasterize rows [band_y, band_y + band_height) of the source drawn at scale into band.
+void raster_band(Export_Source *source, float scale, Uint8 *band, int width, int band_y, int band_height, int **indices, int *capacity)
+{
+    // Set background color.
+    memset(band, 0, (size_t)width * band_height * 3);
+
+    // Nodes stick out of their cell by up to a radius, so take one grid row either side.
+    int row0 = (int)floor(band_y / scale / COLLISION_GRID_Y) - 1;
+    int row1 = (int)floor((band_y + band_height) / scale / COLLISION_GRID_Y) + 1;
+
+    Graph *graph = source->graph;
+    Node_Dump *dump = source->dump;
+    int count = graph
+        ? grid_gather(&graph->grid, 0, row0, graph->grid.columns - 1, row1, indices, capacity)
+        : dump_gather_rows(dump, row0, row1, indices, capacity);
+
+    // A graph cut back to an earlier generation still has the later nodes in its grid; they sort to the end.
+    while (graph && count > 0 && (*indices)[count - 1] >= graph->node_count) count -= 1;
+
+    for (int i = 0; i < count; i += 1)
+    {
+        int index = (*indices)[i];
+        if (graph)
+        {
+            Node *node = graph_node(graph, index);
+            raster_disc(band, width, band_y, band_height, vec2_scalar_multiply(node->circle.center, scale), node->circle.radius * scale, node->color);
+        }
+        else
+        {
+            vec2 center = {dump->x[index] * scale, dump->y[index] * scale};
+            SDL_Color color = dump_unpack_color(dump->palette[dump->color[index]]);
+            raster_disc(band, width, band_y, band_height, center, dump->radius[index] * scale, color);
+        }
+    }
+}
+
+typedef struct {
+    Export_Source *source;
+    float scale;
+    int width;
+    int height;
+    int band_count;
+
+    SDL_mutex *lock;
+    SDL_cond *changed;
+    int next_band;
+    int written_count;
+
+    // Band k is encoded into slot k % slot_count, and a worker won't start a band
+    // until the writer is done with whatever was in its slot.
+    Png_Strip *slots;
+    int slot_count;
+} Export_Job;
+
+int export_worker(void *data)
+{
+    Export_Job *job = data;
+
+    size_t band_size = (size_t)job->width * EXPORT_BAND_HEIGHT * 3;
+    Uint8 *band = memory_alloc(MEMORY_FRAMEBUFFERS, band_size);
+    Uint8 *filtered = memory_alloc(MEMORY_FRAMEBUFFERS, 1 + (size_t)job->width * 3);
+    Deflate *deflate = memory_calloc(MEMORY_SCRATCH, 1, sizeof(Deflate));
+    int *indices = NULL;
+    int capacity = 0;
+
+    Trace *trace = job->source->trace;
+    if (trace) trace_name_thread(trace, "export");
+
+    // Counters only count the thread that opened them, so each worker has its own.
+    Perf_Counters perf;
+    bool counting = job->source->perf && perf_open(&perf);
+
+    for (;;)
+    {
+        SDL_LockMutex(job->lock);
+        while (job->next_band < job->band_count && job->next_band >= job->written_count + job->slot_count)
+        {
+            SDL_CondWait(job->changed, job->lock);
+        }
+        int band_index = job->next_band;
+        if (band_index < job->band_count) job->next_band += 1;
+        SDL_UnlockMutex(job->lock);
+
+        if (counting) perf_lap(&perf, EXPORT_PERF_WAITING);
+        if (band_index >= job->band_count) break;
+
+        int band_y = band_index * EXPORT_BAND_HEIGHT;
+        int band_height = job->height - band_y < EXPORT_BAND_HEIGHT ? job->height - band_y : EXPORT_BAND_HEIGHT;
+        Png_Strip *strip = &job->slots[band_index % job->slot_count];
+
+        Uint64 start = trace ? SDL_GetPerformanceCounter() : 0;
+        raster_band(job->source, job->scale, band, job->width, band_y, band_height, &indices, &capacity);
+        Uint64 rastered = trace ? SDL_GetPerformanceCounter() : 0;
+        if (counting) perf_lap(&perf, EXPORT_PERF_RASTER);
+
+        png_encode_strip(deflate, filtered, band, job->width, band_height, strip);
+        if (counting) perf_lap(&perf, EXPORT_PERF_ENCODE);
+
+        if (trace)
+        {
+            trace_span(trace, "export", "raster", start, rastered, band_index, -1);
+            trace_span(trace, "export", "encode", rastered, SDL_GetPerformanceCounter(), band_index, -1);
+        }
+
+        SDL_LockMutex(job->lock);
+        strip->ready = true;
+        SDL_CondBroadcast(job->changed);
+        SDL_UnlockMutex(job->lock);
+    }
+
+    if (counting)
+    {
+        perf_close(&perf);
+
+        SDL_LockMutex(job->lock);
+        perf_add(job->source->perf, &perf);
+        SDL_UnlockMutex(job->lock);
+    }
+
+    memory_free(MEMORY_SCRATCH, indices, sizeof(int) * capacity);
+    byte_buffer_free(&deflate->out);
+    memory_free(MEMORY_SCRATCH, deflate, sizeof(Deflate));
+    memory_free(MEMORY_FRAMEBUFFERS, filtered, 1 + (size_t)job->width * 3);
+    memory_free(MEMORY_FRAMEBUFFERS, band, band_size);
+
+    return 0;
+}
+
+bool export_png(Export_Source *source, const char *path, float scale, int thread_count)
+{
+    Export_Job job = {0};
+    job.source = source;
+    job.scale = scale;
+    job.width = (int)(source->window.x * scale + 0.5);
+    job.height = (int)(source->window.y * scale + 0.5);
+    job.band_count = (job.height + EXPORT_BAND_HEIGHT - 1) / EXPORT_BAND_HEIGHT;
+
+    Png_Writer png;
+    if (!png_begin(&png, path, job.width, job.height)) return false;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    if (thread_count < 1) thread_count = 1;
+    job.slot_count = thread_count * 2;
+    job.slots = memory_calloc(MEMORY_SCRATCH, job.slot_count, sizeof(Png_Strip));
+    job.lock = SDL_CreateMutex();
+    job.changed = SDL_CreateCond();
+
+    SDL_Thread **threads = memory_alloc(MEMORY_SCRATCH, sizeof(SDL_Thread *) * thread_count);
+    for (int i = 0; i < thread_count; i += 1)
+    {
+        threads[i] = SDL_CreateThread(export_worker, "export", &job);
+    }
+
+    for (int i = 0; i < job.band_count; i += 1)
+    {
+        Png_Strip *strip = &job.slots[i % job.slot_count];
+
+        SDL_LockMutex(job.lock);
+        while (!strip->ready) SDL_CondWait(job.changed, job.lock);
+        SDL_UnlockMutex(job.lock);
+
+        png_write_strip(&png, strip);
+
+        SDL_LockMutex(job.lock);
+        strip->ready = false;
+        job.written_count = i + 1;
+        SDL_CondBroadcast(job.changed);
+        SDL_UnlockMutex(job.lock);
+    }
+
+    for (int i = 0; i < thread_count; i += 1)
+    {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    double megabytes = (double)(1 + job.width * 3) * job.height / (1024 * 1024);
+    printf("encoded %.1f MB in %.2f s (%.1f MB/s, %d threads)\n", megabytes, seconds, megabytes / seconds, thread_count);
+
+    for (int i = 0; i < job.slot_count; i += 1)
+    {
+        byte_buffer_free(&job.slots[i].compressed);
+    }
+    memory_free(MEMORY_SCRATCH, job.slots, sizeof(Png_Strip) * job.slot_count);
+    memory_free(MEMORY_SCRATCH, threads, sizeof(SDL_Thread *) * thread_count);
+    SDL_DestroyCond(job.changed);
+    SDL_DestroyMutex(job.lock);
+
+    return png_end(&png);
+}
@@ -0,0 +1,301 @@
+//
+// Decision genome.
+// Given the window and node cap, a run is fully determined by its initial nodes
+// and a handful of yes/no decisions per node: did the continuation fit, which
+// way did it turn, did it spawn a branch and which way. A genome records those
+// bits through an adaptive binary range coder (the LZMA kind), each kind of
+// decision with its own probability model, and can replay them later without
+// touching the random generator or running a single collision test.
+//
+
+#define GENOME_MAGIC 0x47505948 // "HYPG"
+#define GENOME_VERSION 2
+
+// Decision models. Whether a continuation fits mostly depends on how thin the
+// branch is, and how likely a spawn is depends on the branch id.
+#define GENOME_ACCEPTED(radius) ((radius) < 15 ? (radius) : 15)
+#define GENOME_HEADS 16
+#define GENOME_SPAWN(branch) (17 + ((branch) < 63 ? (branch) : 63))
+#define GENOME_SPAWN_HEADS 81
+#define GENOME_MODEL_COUNT 82
+
+#define GENOME_PROBABILITY_BITS 11
+#define GENOME_ADAPT_SHIFT 5
+
+typedef struct {
+    int window_x;
+    int window_y;
+    int initial_point_count;
+    int max_nodes;
+    unsigned int seed;
+
+    // One per initial point.
+    Uint16 *directions;
+    SDL_Color *colors;
+    int initial_capacity;
+
+    // The coded decisions.
+    Uint8 *bytes;
+    size_t count;
+    size_t capacity;
+    Uint64 decision_count;
+
+    // Range coder state, for whichever way it's running.
+    Uint16 models[GENOME_MODEL_COUNT];
+    Uint64 low;
+    Uint32 range;
+    Uint32 code;
+    Uint8 cache;
+    Uint64 cache_size;
+    size_t read_position;
+} Genome;
+
+void genome_put_byte(Genome *genome, Uint8 byte)
+{
+    if (genome->count == genome->capacity)
+    {
+        size_t capacity = genome->capacity ? genome->capacity * 2 : 4096;
+        genome->bytes = memory_realloc(MEMORY_SCRATCH, genome->bytes, genome->capacity, capacity);
+        genome->capacity = capacity;
+    }
+
+    genome->bytes[genome->count] = byte;
+    genome->count += 1;
+}
+
+Uint8 genome_get_byte(Genome *genome)
+{
+    // Past the end reads as zeros, same as the encoder's flush would have written.
+    if (genome->read_position >= genome->count) return 0;
+
+    Uint8 byte = genome->bytes[genome->read_position];
+    genome->read_position += 1;
+    return byte;
+}
+
+void genome_reset_models(Genome *genome)
+{
+    for (int i = 0; i < GENOME_MODEL_COUNT; i += 1)
+    {
+        genome->models[i] = 1 << (GENOME_PROBABILITY_BITS - 1);
+    }
+    genome->decision_count = 0;
+}
+
+void genome_set_initial(Genome *genome, int index, float direction, SDL_Color color)
+{
+    if (index >= genome->initial_capacity)
+    {
+        int capacity = (index + 1) * 2;
+        genome->directions = memory_realloc(MEMORY_SCRATCH, genome->directions, sizeof(Uint16) * genome->initial_capacity, sizeof(Uint16) * capacity);
+        genome->colors = memory_realloc(MEMORY_SCRATCH, genome->colors, sizeof(SDL_Color) * genome->initial_capacity, sizeof(SDL_Color) * capacity);
+        genome->initial_capacity = capacity;
+    }
+
+    genome->directions[index] = (Uint16)direction;
+    genome->colors[index] = color;
+}
+
+void genome_begin_record(Genome *genome)
+{
+    genome->count = 0;
+    genome->low = 0;
+    genome->range = 0xFFFFFFFF;
+    genome->cache = 0;
+    genome->cache_size = 1;
+    genome_reset_models(genome);
+}
+
+// Push the top byte of low out, holding back runs of 0xFF until it's known whether a carry reaches them.
+void genome_shift_low(Genome *genome)
+{
+    if ((Uint32)genome->low < 0xFF000000 || (genome->low >> 32) != 0)
+    {
+        Uint8 carry = (Uint8)(genome->low >> 32);
+        Uint8 byte = genome->cache;
+        do
+        {
+            genome_put_byte(genome, byte + carry);
+            byte = 0xFF;
+            genome->cache_size -= 1;
+        } while (genome->cache_size != 0);
+
+        genome->cache = (Uint8)(genome->low >> 24);
+    }
+
+    genome->cache_size += 1;
+    genome->low = (genome->low & 0x00FFFFFF) << 8;
+}
+
+void genome_write(Genome *genome, int model, bool bit)
+{
+    Uint16 *probability = &genome->models[model];
+    Uint32 bound = (genome->range >> GENOME_PROBABILITY_BITS) * *probability;
+
+    if (!bit)
+    {
+        genome->range = bound;
+        *probability += ((1 << GENOME_PROBABILITY_BITS) - *probability) >> GENOME_ADAPT_SHIFT;
+    }
+    else
+    {
+        genome->low += bound;
+        genome->range -= bound;
+        *probability -= *probability >> GENOME_ADAPT_SHIFT;
+    }
+
+    while (genome->range < (1 << 24))
+    {
+        genome->range <<= 8;
+        genome_shift_low(genome);
+    }
+
+    genome->decision_count += 1;
+}
+
+void genome_end_record(Genome *genome)
+{
+    for (int i = 0; i < 5; i += 1) genome_shift_low(genome);
+}
+
+void genome_begin_replay(Genome *genome)
+{
+    genome->read_position = 0;
+    genome->range = 0xFFFFFFFF;
+    genome->code = 0;
+    for (int i = 0; i < 5; i += 1)
+    {
+        genome->code = (genome->code << 8) | genome_get_byte(genome);
+    }
+    genome_reset_models(genome);
+}
+
+bool genome_read(Genome *genome, int model)
+{
+    Uint16 *probability = &genome->models[model];
+    Uint32 bound = (genome->range >> GENOME_PROBABILITY_BITS) * *probability;
+    bool bit;
+
+    if (genome->code < bound)
+    {
+        genome->range = bound;
+        *probability += ((1 << GENOME_PROBABILITY_BITS) - *probability) >> GENOME_ADAPT_SHIFT;
+        bit = false;
+    }
+    else
+    {
+        genome->code -= bound;
+        genome->range -= bound;
+        *probability -= *probability >> GENOME_ADAPT_SHIFT;
+        bit = true;
+    }
+
+    while (genome->range < (1 << 24))
+    {
+        genome->range <<= 8;
+        genome->code = (genome->code << 8) | genome_get_byte(genome);
+    }
+
+    genome->decision_count += 1;
+    return bit;
+}
+
+void genome_free(Genome *genome)
+{
+    memory_free(MEMORY_SCRATCH, genome->directions, sizeof(Uint16) * genome->initial_capacity);
+    memory_free(MEMORY_SCRATCH, genome->colors, sizeof(SDL_Color) * genome->initial_capacity);
+    memory_free(MEMORY_SCRATCH, genome->bytes, genome->capacity);
+    memset(genome, 0, sizeof(Genome));
+}
+
+void genome_put_u32(FILE *file, Uint32 value)
+{
+    Uint8 bytes[4] = {(Uint8)value, (Uint8)(value >> 8), (Uint8)(value >> 16), (Uint8)(value >> 24)};
+    fwrite(bytes, 1, 4, file);
+}
+
+bool genome_get_u32(FILE *file, Uint32 *value)
+{
+    Uint8 bytes[4];
+    if (fread(bytes, 1, 4, file) != 4) return false;
+
+    *value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((Uint32)bytes[3] << 24);
+    return true;
+}
+
+// Little-endian: magic, version, window size, initial point count, node cap, seed,
+// decision count (two words), coded byte count, then 5 bytes (direction, rgb) per
+// initial point and the coded bytes.
+bool genome_save(Genome *genome, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    genome_put_u32(file, GENOME_MAGIC);
+    genome_put_u32(file, GENOME_VERSION);
+    genome_put_u32(file, genome->window_x);
+    genome_put_u32(file, genome->window_y);
+    genome_put_u32(file, genome->initial_point_count);
+    genome_put_u32(file, genome->max_nodes);
+    genome_put_u32(file, genome->seed);
+    genome_put_u32(file, (Uint32)genome->decision_count);
+    genome_put_u32(file, (Uint32)(genome->decision_count >> 32));
+    genome_put_u32(file, (Uint32)genome->count);
+
+    for (int i = 0; i < genome->initial_point_count; i += 1)
+    {
+        SDL_Color color = genome->colors[i];
+        Uint8 initial[5] = {(Uint8)genome->directions[i], (Uint8)(genome->directions[i] >> 8), color.r, color.g, color.b};
+        fwrite(initial, 1, 5, file);
+    }
+
+    fwrite(genome->bytes, 1, genome->count, file);
+
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+bool genome_load(Genome *genome, const char *path)
+{
+    memset(genome, 0, sizeof(Genome));
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    Uint32 magic = 0, version = 0, window_x = 0, window_y = 0, initial_point_count = 0, max_nodes = 0;
+    Uint32 decisions_low = 0, decisions_high = 0, count = 0;
+    bool ok = genome_get_u32(file, &magic) && magic == GENOME_MAGIC &&
+        genome_get_u32(file, &version) && version == GENOME_VERSION &&
+        genome_get_u32(file, &window_x) && genome_get_u32(file, &window_y) &&
+        genome_get_u32(file, &initial_point_count) && genome_get_u32(file, &max_nodes) &&
+        genome_get_u32(file, &genome->seed) &&
+        genome_get_u32(file, &decisions_low) && genome_get_u32(file, &decisions_high) &&
+        genome_get_u32(file, &count) &&
+        (int)window_x > 0 && (int)window_y > 0 && (int)initial_point_count >= 0 && (int)max_nodes > 0;
+
+    genome->window_x = window_x;
+    genome->window_y = window_y;
+    genome->initial_point_count = initial_point_count;
+    genome->max_nodes = max_nodes;
+    genome->decision_count = decisions_low | ((Uint64)decisions_high << 32);
+
+    for (int i = 0; ok && i < genome->initial_point_count; i += 1)
+    {
+        Uint8 initial[5];
+        ok = fread(initial, 1, 5, file) == 5;
+        if (ok) genome_set_initial(genome, i, initial[0] | (initial[1] << 8), (SDL_Color){initial[2], initial[3], initial[4], 255});
+    }
+
+    if (ok && count > 0)
+    {
+        genome->bytes = memory_alloc(MEMORY_SCRATCH, count);
+        genome->capacity = count;
+        genome->count = count;
+        ok = fread(genome->bytes, 1, count, file) == count;
+    }
+
+    fclose(file);
+    if (!ok) genome_free(genome);
+    return ok;
+}
@@ -0,0 +1,194 @@
+//
+// Golden digests, for checking that a change hasn't changed what grows.
+// Each case is grown headless from a fixed seed, then its nodes' structure
+// (branch, parent, radius and color) and its image as the export would
+// rasterize it are each hashed with 64-bit FNV-1a. A golden file has a line per
+// case, with # starting a comment:
+//
+//   width height points max_nodes seed   nodes generations   node_digest image_digest
+//
+// Positions come out of the C library's sin and cos, which aren't the same from
+// one toolchain to the next, so they're left out of the node digest; they only
+// change the structure if a collision comes out differently. The image can't
+// leave them out, so image digests only hold for builds like the one that wrote
+// them. The file says which toolchain that was on a line of its own:
+//
+//   toolchain gcc 12.2.0, glibc 2.36, x86_64
+//
+
+#define GOLDEN_MAX_CASES 32
+#define GOLDEN_TOOLCHAIN_MAX 128
+#define GOLDEN_FNV_OFFSET 0xcbf29ce484222325ULL
+#define GOLDEN_FNV_PRIME 0x100000001b3ULL
+
+#define GOLDEN_STRING(x) GOLDEN_STRING_(x)
+#define GOLDEN_STRING_(x) #x
+
+// What this build's float math comes from: the compiler, the C library's and the architecture.
+#if defined(_MSC_VER)
+#define GOLDEN_COMPILER "msvc " GOLDEN_STRING(_MSC_FULL_VER)
+#elif defined(__clang__)
+#define GOLDEN_COMPILER "clang " __clang_version__
+#elif defined(__GNUC__)
+#define GOLDEN_COMPILER "gcc " __VERSION__
+#else
+#define GOLDEN_COMPILER "unknown compiler"
+#endif
+
+#if defined(__GLIBC__)
+#define GOLDEN_LIBRARY ", glibc " GOLDEN_STRING(__GLIBC__) "." GOLDEN_STRING(__GLIBC_MINOR__)
+#elif defined(__MINGW32__)
+#define GOLDEN_LIBRARY ", mingw"
+#else
+#define GOLDEN_LIBRARY ""
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GOLDEN_ARCHITECTURE ", x86_64"
+#elif defined(__i386__) || defined(_M_IX86)
+#define GOLDEN_ARCHITECTURE ", x86"
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define GOLDEN_ARCHITECTURE ", arm64"
+#else
+#define GOLDEN_ARCHITECTURE ""
+#endif
+
+#define GOLDEN_TOOLCHAIN GOLDEN_COMPILER GOLDEN_LIBRARY GOLDEN_ARCHITECTURE
+
+typedef struct {
+    Window size;
+    int initial_point_count;
+    int max_nodes;
+    unsigned int seed;
+
+    int node_count;
+    int generation_count;
+    Uint64 node_digest;
+    Uint64 image_digest;
+} Golden_Case;
+
+// What --update-golden grows: the default diagram, and a few that end for other reasons.
+Golden_Case golden_default_cases[] = {
+    {.size = {1440, 980}, .initial_point_count = 3, .max_nodes = 40000, .seed = 42},
+    {.size = {1440, 980}, .initial_point_count = 12, .max_nodes = 40000, .seed = 7},
+    {.size = {640, 480}, .initial_point_count = 5, .max_nodes = 40000, .seed = 1},
+    {.size = {2880, 1960}, .initial_point_count = 3, .max_nodes = 10000, .seed = 3},
+};
+
+Uint64 golden_hash(Uint64 hash, const Uint8 *bytes, size_t count)
+{
+    for (size_t i = 0; i < count; i += 1)
+    {
+        hash = (hash ^ bytes[i]) * GOLDEN_FNV_PRIME;
+    }
+    return hash;
+}
+
+// Little-endian whatever the machine, so digests compare across them.
+Uint64 golden_hash_int(Uint64 hash, Sint64 value)
+{
+    Uint8 bytes[8];
+    for (int i = 0; i < 8; i += 1)
+    {
+        bytes[i] = (Uint8)((Uint64)value >> (i * 8));
+    }
+    return golden_hash(hash, bytes, 8);
+}
+
+Uint64 golden_node_digest(Graph *graph)
+{
+    Uint64 hash = GOLDEN_FNV_OFFSET;
+    for (int i = 0; i < graph->node_count; i += 1)
+    {
+        Node *node = graph_node(graph, i);
+        hash = golden_hash_int(hash, node->branch);
+        hash = golden_hash_int(hash, node->parent);
+        hash = golden_hash_int(hash, node->circle.radius);
+        hash = golden_hash_int(hash, (node->color.r << 16) | (node->color.g << 8) | node->color.b);
+    }
+    return hash;
+}
+
+// Rasterized a band at a time at scale 1, as the PNG export does, and hashed row by row.
+Uint64 golden_image_digest(Graph *graph)
+{
+    Export_Source source = {0};
+    source.graph = graph;
+    source.window = graph->window;
+
+    int width = graph->window.x;
+    size_t band_size = (size_t)width * EXPORT_BAND_HEIGHT * 3;
+    Uint8 *band = memory_alloc(MEMORY_FRAMEBUFFERS, band_size);
+    int *indices = NULL;
+    int capacity = 0;
+
+    Uint64 hash = GOLDEN_FNV_OFFSET;
+    for (int band_y = 0; band_y < graph->window.y; band_y += EXPORT_BAND_HEIGHT)
+    {
+        int band_height = graph->window.y - band_y < EXPORT_BAND_HEIGHT ? graph->window.y - band_y : EXPORT_BAND_HEIGHT;
+        raster_band(&source, 1, band, width, band_y, band_height, &indices, &capacity);
+        hash = golden_hash(hash, band, (size_t)width * band_height * 3);
+    }
+
+    memory_free(MEMORY_FRAMEBUFFERS, band, band_size);
+    memory_free(MEMORY_SCRATCH, indices, sizeof(int) * capacity);
+    return hash;
+}
+
+// Read up to max cases from path, and the toolchain that wrote them into toolchain (empty if it doesn't
+// say). Returns how many cases, or -1 if it can't be read or a line doesn't parse.
+int golden_read(const char *path, Golden_Case *cases, int max, char *toolchain)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return -1;
+
+    toolchain[0] = '\0';
+
+    int count = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file))
+    {
+        char *start = line;
+        while (*start == ' ' || *start == '\t') start += 1;
+        if (*start == '#' || *start == '\r' || *start == '\n' || *start == '\0') continue;
+
+        if (strncmp(start, "toolchain ", 10) == 0)
+        {
+            start += 10;
+            int length = (int)strcspn(start, "\r\n");
+            if (length >= GOLDEN_TOOLCHAIN_MAX) length = GOLDEN_TOOLCHAIN_MAX - 1;
+            memcpy(toolchain, start, length);
+            toolchain[length] = '\0';
+            continue;
+        }
+
+        if (count == max)
+        {
+            count = -1;
+            break;
+        }
+
+        Golden_Case *golden = &cases[count];
+        unsigned long long node_digest, image_digest;
+        if (sscanf(start, "%d %d %d %d %u %d %d %llx %llx", &golden->size.x, &golden->size.y, &golden->initial_point_count, &golden->max_nodes,
+            &golden->seed, &golden->node_count, &golden->generation_count, &node_digest, &image_digest) != 9 ||
+            golden->size.x < 1 || golden->size.y < 1 || golden->initial_point_count < 0 || golden->max_nodes < 1)
+        {
+            count = -1;
+            break;
+        }
+
+        golden->node_digest = node_digest;
+        golden->image_digest = image_digest;
+        count += 1;
+    }
+
+    fclose(file);
+    return count;
+}
+
+void golden_write_case(FILE *file, Golden_Case *golden)
+{
+    fprintf(file, "%d %d %d %d %u   %d %d   %016llx %016llx\n", golden->size.x, golden->size.y, golden->initial_point_count, golden->max_nodes,
+        golden->seed, golden->node_count, golden->generation_count, (unsigned long long)golden->node_digest, (unsigned long long)golden->image_digest);
+}
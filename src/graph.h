@@ -0,0 +1,316 @@
+//
+// The node store the simulation grows and everything else reads.
+//
+
+typedef struct {
+    int x;
+    int y;
+} Window;
+
+typedef struct {
+    int x;
+    int y;
+} Coordinates;
+
+typedef struct {
+    Circle circle;
+    bool has_spawned;
+
+    float direction;
+    float jitter;
+    float spacing;
+    SDL_Color color;
+
+    int branch;
+    int id;
+    int parent;
+    Coordinates collision_grid;
+} Node;
+
+// A branch's nodes form a chain: each one's parent is the one before it, back to
+// the first, whose parent is the node on another branch it spawned from.
+typedef struct {
+    int first;
+    int last;
+    int spawn;
+    int length;
+} Branch;
+
+#define NODES_ON_HEAP
+// #undef NODES_ON_HEAP
+
+#ifdef NODES_ON_HEAP
+#define MAX_NODES 40000
+#else
+#define MAX_NODES 4000
+#endif
+
+// What became of every continuation update() tried: whether it went off screen, and for
+// each node it was checked against, why that node was passed over or whether it hit.
+typedef struct {
+    Uint64 candidates;
+    Uint64 off_screen;
+    Uint64 far_cells;
+    Uint64 same_branch;
+    Uint64 close_ids;
+    Uint64 circle_tests;
+    Uint64 hits;
+} Collision_Counts;
+
+// The grid's answer to whether each continuation collides, checked against the full scan's,
+// and where the two first disagreed if they ever did.
+typedef struct {
+    Uint64 checked_count;
+    bool diverged;
+    int generation;
+    int node_index;
+    int parent;
+    vec2 center;
+    bool full_scan_collided;
+
+    // Scratch for the grid query.
+    int *indices;
+    int capacity;
+} Divergence;
+
+// A node still to be continued, with what update() orders them by.
+typedef struct {
+    float x;
+    int index;
+} Frontier_Node;
+
+#define COLLISION_GRID_X 20 
+#define COLLISION_GRID_Y 20 
+
+typedef struct {
+    // Copy-on-write pages of Node, with room for max_nodes. The directory never
+    // moves, so another Graph can read the same nodes through a copy of it.
+    Paged_Array nodes;
+    int node_count;
+    int initial_point_count;
+
+    int active_point_count;
+
+    int max_nodes;
+
+    // What the generator was seeded with for this run, so it can be recorded alongside the result.
+    unsigned int seed;
+    Uint64 random_state;
+
+    // How many times update() has committed a generation this run, and how many
+    // nodes there were once each one had been: nodes are only ever appended, so
+    // the diagram as of any generation is a prefix of them.
+    int generation;
+    int *generation_ends;
+    int generation_capacity;
+
+    int next_branch;
+    int next_id;
+
+    // Pages of Branch indexed by branch id, which starts at 1.
+    Paged_Array branches;
+
+    // Percent chance, scaled by the branch id, that a new node spawns a branch.
+    float spawn_chance;
+
+    bool do_iteration;
+    bool starting_new;
+
+    // Where update() gathers a generation's new nodes before committing them. Kept from one generation to the next.
+    Node *nodes_to_add;
+    int nodes_to_add_capacity;
+
+    // The nodes that haven't spawned yet, left to right, which is the order update() continues them in.
+    Frontier_Node *frontier;
+    int frontier_capacity;
+
+    // How long update() spent in each phase of the last generation, and on the whole of it.
+    Phase_Times phase_times;
+    Uint64 generation_ticks;
+
+    // The collision pass's work in the last generation, and over the whole run.
+    Collision_Counts collisions;
+    Collision_Counts total_collisions;
+
+    // If set, update() writes its decisions into record, or takes them from replay instead of the generator.
+    Genome *record;
+    Genome *replay;
+
+    // Where to put a span per generation, if anywhere.
+    Trace *trace;
+
+    // Where to publish progress after every generation, if anywhere.
+    Metrics *metrics;
+
+    // If set, update() runs the grid's collision query alongside the full scan and notes where they first disagree.
+    Divergence *differential;
+
+    Window window;
+    Grid grid;
+} Graph;
+
+// PCG32. The graph has its own generator rather than using rand(), so its whole
+// state is one number that can be checkpointed along with everything else.
+Uint32 graph_random(Graph *graph)
+{
+    Uint64 state = graph->random_state;
+    graph->random_state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+    Uint32 xorshifted = (Uint32)(((state >> 18) ^ state) >> 27);
+    Uint32 rotation = (Uint32)(state >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+}
+
+void graph_seed(Graph *graph, unsigned int seed)
+{
+    graph->seed = seed;
+    graph->random_state = 0;
+    graph_random(graph);
+    graph->random_state += seed;
+    graph_random(graph);
+}
+
+// Set up an empty graph that can hold max_nodes.
+void graph_init(Graph *graph, int max_nodes)
+{
+    memset(graph, 0, sizeof(Graph));
+    graph->max_nodes = max_nodes;
+    graph->spawn_chance = 1.5;
+
+    paged_init(&graph->nodes, sizeof(Node), max_nodes, MEMORY_NODES);
+
+    // Every branch has at least one node.
+    paged_init(&graph->branches, sizeof(Branch), max_nodes + 1, MEMORY_BRANCHES);
+}
+
+Node *graph_node(Graph *graph, int index)
+{
+    return paged_get(&graph->nodes, index);
+}
+
+// For changing a node; the page it's on gets copied first if it's shared with a fork.
+Node *graph_edit_node(Graph *graph, int index)
+{
+    return paged_edit(&graph->nodes, index);
+}
+
+Branch *graph_branch(Graph *graph, int branch_id)
+{
+    return paged_get(&graph->branches, branch_id);
+}
+
+void graph_reset(Graph *graph)
+{
+    graph->node_count = 0;
+    graph->generation = 0;
+    memset(&graph->total_collisions, 0, sizeof(Collision_Counts));
+    graph->next_branch = 1;
+    graph->next_id = 0;
+
+    grid_reset(&graph->grid, graph->window.x / COLLISION_GRID_X + 1, graph->window.y / COLLISION_GRID_Y + 1);
+
+    // Branch pages come back zeroed when they're next edited.
+    paged_clear(&graph->branches);
+}
+
+// Append a node, filing it in the grid and on the end of its branch.
+void graph_commit(Graph *graph, Node node)
+{
+    int index = graph->node_count;
+    *graph_edit_node(graph, index) = node;
+    graph->node_count += 1;
+
+    grid_add(&graph->grid, node.collision_grid.x, node.collision_grid.y, index);
+
+    Branch *branch = paged_edit(&graph->branches, node.branch);
+    if (branch->length == 0)
+    {
+        branch->first = index;
+        branch->spawn = node.parent;
+    }
+    branch->last = index;
+    branch->length += 1;
+}
+
+void collision_counts_add(Collision_Counts *total, Collision_Counts *counts)
+{
+    total->candidates += counts->candidates;
+    total->off_screen += counts->off_screen;
+    total->far_cells += counts->far_cells;
+    total->same_branch += counts->same_branch;
+    total->close_ids += counts->close_ids;
+    total->circle_tests += counts->circle_tests;
+    total->hits += counts->hits;
+}
+
+// Mark everything committed so far as one more generation.
+void graph_end_generation(Graph *graph)
+{
+    if (graph->generation == graph->generation_capacity)
+    {
+        int capacity = graph->generation_capacity ? graph->generation_capacity * 2 : 256;
+        graph->generation_ends = memory_realloc(MEMORY_NODES, graph->generation_ends, sizeof(int) * graph->generation_capacity, sizeof(int) * capacity);
+        graph->generation_capacity = capacity;
+    }
+
+    graph->generation_ends[graph->generation] = graph->node_count;
+    graph->generation += 1;
+}
+
+// How many nodes make up the diagram as of generation (1 being the first).
+int graph_generation_end(Graph *graph, int generation)
+{
+    if (generation <= 0) return 0;
+    if (generation >= graph->generation) return graph->node_count;
+
+    return graph->generation_ends[generation - 1];
+}
+
+// Fill indices (room for the branch's length) with its nodes from first to last. Returns how many.
+int branch_chain(Graph *graph, int branch_id, int *indices)
+{
+    if (branch_id < 1 || branch_id >= graph->next_branch) return 0;
+
+    Branch *branch = graph_branch(graph, branch_id);
+    if (!branch) return 0;
+
+    int index = branch->last;
+    for (int i = branch->length - 1; i >= 0; i -= 1)
+    {
+        indices[i] = index;
+        index = graph_node(graph, index)->parent;
+    }
+
+    return branch->length;
+}
+
+// Make fork an independent copy of graph, as it stands, that shares all its pages.
+// Either one can carry on growing; only the pages one of them changes get copied.
+void graph_fork(Graph *fork, Graph *graph)
+{
+    *fork = *graph;
+    fork->record = NULL;
+    fork->replay = NULL;
+    fork->nodes_to_add = NULL;
+    fork->nodes_to_add_capacity = 0;
+    fork->frontier = NULL;
+    fork->frontier_capacity = 0;
+
+    fork->generation_capacity = graph->generation_capacity + 1;
+    fork->generation_ends = memory_alloc(MEMORY_NODES, sizeof(int) * fork->generation_capacity);
+    memcpy(fork->generation_ends, graph->generation_ends, sizeof(int) * graph->generation);
+
+    paged_fork(&fork->nodes, &graph->nodes);
+    paged_fork(&fork->branches, &graph->branches);
+    grid_fork(&fork->grid, &graph->grid);
+}
+
+void graph_free(Graph *graph)
+{
+    memory_free(MEMORY_NODES, graph->generation_ends, sizeof(int) * graph->generation_capacity);
+    memory_free(MEMORY_SCRATCH, graph->nodes_to_add, sizeof(Node) * graph->nodes_to_add_capacity);
+    memory_free(MEMORY_FRONTIER, graph->frontier, sizeof(Frontier_Node) * graph->frontier_capacity);
+    paged_free(&graph->nodes);
+    paged_free(&graph->branches);
+    grid_free(&graph->grid);
+}
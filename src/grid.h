@@ -0,0 +1,163 @@
+//
+// Uniform grid of node indices, one bucket per cell.
+// Cells outside the grid are clamped onto its edge, so a query that's clamped
+// the same way still sees every node.
+// A bucket is a chain of small chunks linked back from its newest, all taken
+// from one append-only pool. Cells and chunks both live in copy-on-write pages,
+// so a forked grid shares everything with the original and only copies what
+// it adds to.
+//
+
+#define GRID_CHUNK_ITEMS 15
+
+typedef struct {
+    int items[GRID_CHUNK_ITEMS];
+    int previous;
+} Grid_Chunk;
+
+typedef struct {
+    int last;
+    int count;
+} Grid_Cell;
+
+typedef struct {
+    Paged_Array cells;
+    Paged_Array chunks;
+    int chunk_count;
+    int columns;
+    int rows;
+} Grid;
+
+int grid_clamp(int value, int count)
+{
+    if (value < 0) return 0;
+    if (value >= count) return count - 1;
+    return value;
+}
+
+// Size the grid to cover columns x rows cells and empty it. Chunk pages are reused between runs.
+void grid_reset(Grid *grid, int columns, int rows)
+{
+    if (columns < 1) columns = 1;
+    if (rows < 1) rows = 1;
+
+    if (columns * rows > grid->cells.page_count * PAGE_ITEMS)
+    {
+        paged_free(&grid->cells);
+        paged_init(&grid->cells, sizeof(Grid_Cell), columns * rows, MEMORY_GRID);
+    }
+    else
+    {
+        paged_clear(&grid->cells);
+    }
+
+    if (!grid->chunks.pages) paged_init(&grid->chunks, sizeof(Grid_Chunk), PAGE_ITEMS, MEMORY_GRID);
+    grid->chunk_count = 0;
+
+    grid->columns = columns;
+    grid->rows = rows;
+}
+
+int grid_cell_index(Grid *grid, int x, int y)
+{
+    return grid_clamp(y, grid->rows) * grid->columns + grid_clamp(x, grid->columns);
+}
+
+void grid_add(Grid *grid, int x, int y, int index)
+{
+    Grid_Cell *cell = paged_edit(&grid->cells, grid_cell_index(grid, x, y));
+
+    int slot = cell->count % GRID_CHUNK_ITEMS;
+
+    // Start a new chunk when the last one's full, and also when it's shared with
+    // another fork: copying its few items beats copying the page it's on.
+    if (slot == 0 || paged_shared(&grid->chunks, cell->last))
+    {
+        paged_reserve(&grid->chunks, grid->chunk_count + 1);
+        Grid_Chunk *chunk = paged_edit(&grid->chunks, grid->chunk_count);
+
+        if (slot == 0)
+        {
+            chunk->previous = cell->count > 0 ? cell->last : -1;
+        }
+        else
+        {
+            *chunk = *(Grid_Chunk *)paged_get(&grid->chunks, cell->last);
+        }
+
+        cell->last = grid->chunk_count;
+        grid->chunk_count += 1;
+    }
+
+    Grid_Chunk *chunk = paged_edit(&grid->chunks, cell->last);
+    chunk->items[slot] = index;
+    cell->count += 1;
+}
+
+// Share everything with grid; either can be added to afterwards without the other seeing it.
+void grid_fork(Grid *fork, Grid *grid)
+{
+    *fork = *grid;
+    paged_fork(&fork->cells, &grid->cells);
+    paged_fork(&fork->chunks, &grid->chunks);
+}
+
+void grid_free(Grid *grid)
+{
+    paged_free(&grid->cells);
+    paged_free(&grid->chunks);
+    memset(grid, 0, sizeof(Grid));
+}
+
+int index_compare(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+// Collect the indices in cells [x0, x1] x [y0, y1] into *indices (grown as needed), sorted
+// back into the order they were added. Returns how many there were.
+int grid_gather(Grid *grid, int x0, int y0, int x1, int y1, int **indices, int *capacity)
+{
+    if (grid->cells.pages == NULL) return 0;
+
+    x0 = grid_clamp(x0, grid->columns);
+    y0 = grid_clamp(y0, grid->rows);
+    x1 = grid_clamp(x1, grid->columns);
+    y1 = grid_clamp(y1, grid->rows);
+
+    int count = 0;
+    for (int y = y0; y <= y1; y += 1)
+    {
+        for (int x = x0; x <= x1; x += 1)
+        {
+            Grid_Cell *cell = paged_get(&grid->cells, grid_cell_index(grid, x, y));
+            if (!cell || cell->count == 0) continue;
+
+            if (count + cell->count > *capacity)
+            {
+                int grown = (count + cell->count) * 2;
+                *indices = memory_realloc(MEMORY_SCRATCH, *indices, sizeof(int) * *capacity, sizeof(int) * grown);
+                *capacity = grown;
+            }
+
+            // Walk the chunks back from the newest; only that one can be partly filled.
+            int remaining = cell->count;
+            int chunk_index = cell->last;
+            int filled = (remaining - 1) % GRID_CHUNK_ITEMS + 1;
+            while (remaining > 0)
+            {
+                Grid_Chunk *chunk = paged_get(&grid->chunks, chunk_index);
+                memcpy(*indices + count + remaining - filled, chunk->items, sizeof(int) * filled);
+
+                remaining -= filled;
+                filled = GRID_CHUNK_ITEMS;
+                chunk_index = chunk->previous;
+            }
+            count += cell->count;
+        }
+    }
+
+    qsort(*indices, count, sizeof(int), index_compare);
+
+    return count;
+}
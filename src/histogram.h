@@ -0,0 +1,86 @@
+//
+// HDR-style histogram of durations in microseconds.
+// Buckets are exact below 128 us; above that, every power of two is split into
+// 64 buckets, so any value lands within 1/64 of where it's counted, and the
+// whole range up to weeks fits in a fixed few kilobytes. Recording is a bit
+// scan and an increment, so it can run for as long as the program does.
+//
+
+#define HISTOGRAM_SUB_BITS 6
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_SHIFT 34
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_SHIFT + 2) * HISTOGRAM_SUB_COUNT)
+
+typedef struct {
+    Uint32 counts[HISTOGRAM_BUCKETS];
+    Uint64 total;
+    Uint64 max;
+} Histogram;
+
+int histogram_bucket(Uint64 value)
+{
+    if (value < 2 * HISTOGRAM_SUB_COUNT) return (int)value;
+
+    int high_bit = 63;
+    while (!(value >> high_bit)) high_bit -= 1;
+
+    int shift = high_bit - HISTOGRAM_SUB_BITS;
+    if (shift > HISTOGRAM_MAX_SHIFT) return HISTOGRAM_BUCKETS - 1;
+
+    return shift * HISTOGRAM_SUB_COUNT + (int)(value >> shift);
+}
+
+// The largest value that lands in bucket.
+Uint64 histogram_bucket_value(int bucket)
+{
+    if (bucket < 2 * HISTOGRAM_SUB_COUNT) return bucket;
+
+    int shift = bucket / HISTOGRAM_SUB_COUNT - 1;
+    Uint64 mantissa = bucket - shift * HISTOGRAM_SUB_COUNT;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void histogram_record(Histogram *histogram, Uint64 microseconds)
+{
+    histogram->counts[histogram_bucket(microseconds)] += 1;
+    histogram->total += 1;
+    if (microseconds > histogram->max) histogram->max = microseconds;
+}
+
+void histogram_record_ticks(Histogram *histogram, Uint64 ticks)
+{
+    histogram_record(histogram, ticks * 1000000 / SDL_GetPerformanceFrequency());
+}
+
+void histogram_reset(Histogram *histogram)
+{
+    memset(histogram, 0, sizeof(Histogram));
+}
+
+// The value, in milliseconds, that percentile percent of everything recorded is at or below.
+double histogram_percentile(Histogram *histogram, double percentile)
+{
+    if (histogram->total == 0) return 0;
+
+    Uint64 rank = (Uint64)ceil(histogram->total * percentile / 100);
+    if (rank < 1) rank = 1;
+
+    Uint64 seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i += 1)
+    {
+        seen += histogram->counts[i];
+        if (seen >= rank)
+        {
+            // Never past the largest value actually recorded.
+            Uint64 value = histogram_bucket_value(i);
+            return (value < histogram->max ? value : histogram->max) / 1000.0;
+        }
+    }
+
+    return histogram->max / 1000.0;
+}
+
+double histogram_max(Histogram *histogram)
+{
+    return histogram->max / 1000.0;
+}
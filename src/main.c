@@ -1,559 +1,2769 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-#include <stdbool.h>
-#include "SDL.h"
-#include "SDL_ttf.h"
-#include "SDL_image.h"
-
-#include "vec2.h"
-#include "draw.h"
-
-typedef struct {
-    int x;
-    int y;
-} Window;
-
-typedef struct {
-    int x;
-    int y;
-} Coordinates;
-
-typedef struct {
-    Circle circle;
-    bool has_spawned;
-
-    float direction;
-    float jitter;
-    float spacing;
-    SDL_Color color;
-
-    int branch;
-    int id;
-    Coordinates collision_grid;
-} Node;
-
-typedef struct {
-    TTF_Font *font;
-    SDL_Color font_color;
-    bool show;
-    bool do_iteration;
-    bool quit;
-    bool render_intermediate;
-    bool starting_new;
-    Uint64 frames;
-} UI;
-
-#define NODES_ON_HEAP
-// #undef NODES_ON_HEAP
-
-#define RENDER_ADDITIVE
-// #undef RENDER_ADDITIVE
-
-#ifdef NODES_ON_HEAP
-#define MAX_NODES 40000
-#else
-#define MAX_NODES 4000
-#endif
-
-#define COLLISION_GRID_X 20 
-#define COLLISION_GRID_Y 20 
-
-typedef struct {
-#ifdef NODES_ON_HEAP
-    Node *nodes;
-#else
-    Node nodes[MAX_NODES];
-#endif
-    int node_count;
-    int initial_point_count;
-
-    int active_point_count;
-
-    int max_nodes;
-
-    int next_branch;
-    int next_id;
-
-    Window window;
-} Graph;
-
-int node_compare(const void *a, const void *b)
-{
-    const Node *n1 = a;
-    const Node *n2 = b;
-
-    if (n1->circle.center.x < n2->circle.center.x) {
-        return -1;
-    } else if (n1->circle.center.x == n2->circle.center.x) {
-        return 0;
-    } else {
-        return 1;
-    }
-}
-
-void render_additive(SDL_Renderer *renderer, Graph graph, UI ui, int nodes_added_this_frame)
-{
-    if (ui.starting_new)
-    {
-        SDL_RenderClear(renderer);
-
-        // Set background color.
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        // SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-        SDL_RenderFillRect(renderer, NULL);
-    }
-
-    // Draw new nodes.
-    for (int i = graph.node_count - nodes_added_this_frame; i < graph.node_count; i += 1)
-    {
-        Node node = graph.nodes[i];
-        draw_circle(renderer, node.circle, node.color);
-    }
-
-    SDL_RenderPresent(renderer);
-}
-
-void render(SDL_Renderer *renderer, Graph graph, UI ui)
-{
-    SDL_RenderClear(renderer);
-
-    // Set background color.
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderFillRect(renderer, NULL);
-
-    if (ui.render_intermediate)
-    {
-        // Draw nodes.
-        for (int i = 0; i < graph.node_count; i += 1)
-        {
-            Node node = graph.nodes[i];
-            draw_circle(renderer, node.circle, node.color);
-        }
-    }
-
-    if (ui.show)
-    {
-        // Draw UI.
-        char initial_points_string[20];
-        sprintf(initial_points_string, "%d initial points (up/down to change)", graph.initial_point_count);
-        draw_text(renderer, 5, 5 + 12*0, initial_points_string, ui.font, ui.font_color);
-
-        char active_points_string[20];
-        sprintf(active_points_string, "%d/%d points (%d active)", graph.node_count, graph.max_nodes, graph.active_point_count);
-        draw_text(renderer, 5, 5 + 12*1, active_points_string, ui.font, ui.font_color);
-
-        char fps_string[20];
-        sprintf(fps_string, "%I64d fps", ui.frames);
-        draw_text(renderer, 5, 5 + 12*2, fps_string, ui.font, ui.font_color);
-
-        char rendering_option_string[20];
-        sprintf(rendering_option_string, "intermediate rendering %s (f to toggle)", ui.render_intermediate ? "on" : "off");
-        draw_text(renderer, 5, 5 + 12*3, rendering_option_string, ui.font, ui.font_color);
-
-        char show_string[20];
-        sprintf(show_string, "(tab to show/hide)");
-        draw_text(renderer, 5, 5 + 12*4, show_string, ui.font, ui.font_color);
-    }
-
-    SDL_RenderPresent(renderer);
-}
-
-void update(UI *ui, Graph *graph) 
-{
-    // CONSTANTS
-    float initial_spacing = 14;
-    float initial_jitter = 0.002;
-    float initial_radius = 14;
-
-    int color_min = 56;
-    int color_range= 256 - color_min;
-
-    float radius_shrink_factor = 1.5;
-    float jitter_growth_factor = 1.2;
-    float color_darken_factor = 0.95;
-
-    float new_branch_spacing_boost = 2.5;
-    float new_branch_smallest_radius = 2.0;
-
-    float chance_to_spawn_new_branch = 1.5;
-
-    /* Experimenting
-    float initial_radius = 20;
-    float initial_spacing = initial_radius;
-    float initial_jitter = 0.0025;
-
-    int color_min = 40;
-    int color_range= 256 - color_min;
-
-    float radius_shrink_factor = 1.5;
-    float jitter_growth_factor = 1.2;
-    float color_darken_factor = 0.9;
-
-    float new_branch_spacing_boost = 1.7;
-    float new_branch_smallest_radius = 2.0;
-
-    float chance_to_spawn_new_branch = 2.0;
-    */
-
-    ui->starting_new = false;
-
-    if (ui->do_iteration)
-    {
-        // Zero out the graph.
-        graph->node_count = 0;
-        graph->next_branch = 1;
-        graph->next_id = 0;
-
-        float initial_spacing = 12;
-        float initial_jitter = 0.0015;
-        float initial_radius = 14;
-
-        // TODO(bkaylor): Should initial nodes' directions always be away from the center?
-
-        for (int i = 0; i < graph->initial_point_count; i += 1)
-        {
-            Node initial_node;
-            initial_node.circle = (Circle){{((i+1) * graph->window.x/(graph->initial_point_count+1)), graph->window.y/2}, initial_radius};
-            initial_node.has_spawned = false;
-            initial_node.direction = (float)(rand() % 360);
-            initial_node.branch = graph->next_branch;
-            initial_node.jitter = initial_jitter;
-            initial_node.spacing = initial_spacing;
-            initial_node.color = (SDL_Color){(rand()%color_range) + color_min, (rand()%color_range) + color_min, (rand()%color_range) + color_min, 255};
-
-            // Hardcode colors here if needed!
-#if 0
-            if (i == 0) {
-                initial_node.color = (SDL_Color){140, 26, 39, 255};
-            }
-            if (i == 1) {
-                initial_node.color = (SDL_Color){59, 101, 67, 255};
-            }
-            if (i == 2) {
-                initial_node.color = (SDL_Color){245, 245, 245, 255};
-            }
-#else
-            if (i == 0) {
-                initial_node.color = (SDL_Color){248, 200, 220, 255};
-            }
-            if (i == 1) {
-                initial_node.color = (SDL_Color){255, 255, 255, 255};
-            }
-            if (i == 2) {
-                initial_node.color = (SDL_Color){167, 199, 231, 255};
-            }
-#endif
-            initial_node.collision_grid.x = initial_node.circle.center.x / COLLISION_GRID_X;
-            initial_node.collision_grid.y = initial_node.circle.center.y / COLLISION_GRID_Y;
-
-            graph->next_branch += 1;
-
-            graph->nodes[graph->node_count] = initial_node;
-            graph->node_count += 1;
-        }
-
-        ui->do_iteration = false;
-        ui->starting_new = true;
-    }
-
-    if (!ui->render_intermediate && graph->active_point_count < 1)
-    {
-        ui->render_intermediate = true;
-    }
-
-    if (!ui->starting_new && graph->active_point_count < 1) return; 
-
-#ifdef NODES_ON_HEAP
-    // TODO(bkaylor): Find something better than MAX_NODES?
-    Node *nodes_to_add = malloc(sizeof(Node) * MAX_NODES);
-#else
-    Node nodes_to_add[MAX_NODES];
-#endif
-
-    // Sort nodes by x coordinate.
-    qsort(graph->nodes, graph->node_count, sizeof(Node), node_compare);
-
-    int nodes_to_add_count = 0;
-
-    if (graph->node_count < graph->max_nodes)
-    {
-        for (int i = 0; i < graph->node_count; i += 1)
-        {
-            if (graph->node_count + nodes_to_add_count >= graph->max_nodes) break;
-
-            Node *node = &graph->nodes[i];
-            if (node->has_spawned) continue;
-
-            // Continue the branch by trying to add a new node.
-            bool heads = rand() % 2 == 0;
-
-            Node new_node;
-            new_node.has_spawned = false;
-            new_node.branch = node->branch;
-
-            new_node.id = graph->next_id;
-            graph->next_id += 1;
-
-            new_node.direction = node->direction + (heads ? node->jitter : (node->jitter * -1));
-            new_node.jitter = node->jitter;
-            new_node.spacing = node->spacing;
-            new_node.circle = (Circle){
-                vec2_add(node->circle.center, vec2_scalar_multiply(vec2_normalize(vec2_rotate((vec2){1, 0}, new_node.direction)), new_node.spacing)),
-                node->circle.radius
-            };
-            new_node.color = node->color;
-
-            new_node.collision_grid.x = new_node.circle.center.x / COLLISION_GRID_X;
-            new_node.collision_grid.y = new_node.circle.center.y / COLLISION_GRID_Y;
-
-            node->has_spawned = true;
-
-            // Only add the node if it doesn't collide with another branch.
-            bool new_node_collided = false;
-
-            // Make sure this node didn't go off the screen.
-            if (new_node.circle.center.x < 0 || new_node.circle.center.y < 0 || 
-                new_node.circle.center.x > graph->window.x || new_node.circle.center.y > graph->window.y)
-            {
-                new_node_collided = true;
-            }
-
-            for (int j = 0; j < graph->node_count; j += 1)
-            {
-                Node *node = &graph->nodes[j];
-
-                // Check collision_grid coordinates.
-                int x_coordinate_difference = abs(new_node.collision_grid.x - node->collision_grid.x);
-                int y_coordinate_difference = abs(new_node.collision_grid.y - node->collision_grid.y);
-                if (x_coordinate_difference > 1 || y_coordinate_difference > 1) continue; 
-
-                // We don't care about collisions with our own branch.
-                if (new_node.branch == node->branch) continue;
-
-                // We don't care about collisions with nodes spawned very near the same time as us.
-                if (abs(new_node.id - node->id) < 60) continue;
-
-                // TODO(bkaylor): Add more ways to ignore nodes.
-
-                if (do_circles_collide(new_node.circle, node->circle))
-                {
-                    new_node_collided = true;
-                    break;
-                }
-            }
-
-            if (new_node_collided) continue;
-
-            // If we made it here, the new potential node is valid. Add it to the new nodes list!
-            nodes_to_add[nodes_to_add_count] = new_node;
-            nodes_to_add_count += 1;
-
-            // In addition to continuing existing branches, give each new node in a branch 
-            // a small chance to start a new, smaller branch.
-            if ((new_node.circle.radius > new_branch_smallest_radius) && rand() % 100 < ((new_node.branch+chance_to_spawn_new_branch)*chance_to_spawn_new_branch))
-            {
-                bool heads = rand() % 2 == 0;
-
-                Node new_branch;
-                new_branch.has_spawned = false;
-
-                new_branch.branch = graph->next_branch;
-                graph->next_branch += 1;
-
-                new_branch.id= graph->next_id;
-                graph->next_id += 1;
-
-                new_branch.jitter = new_node.jitter * jitter_growth_factor;
-                new_branch.spacing = new_node.spacing / radius_shrink_factor;
-                new_branch.direction = new_node.direction + (heads ? 1.5 : -1.5);
-                new_branch.circle = (Circle){
-                    vec2_add(new_node.circle.center, vec2_scalar_multiply(vec2_normalize(vec2_rotate((vec2){1, 0}, new_branch.direction)), new_branch.spacing*new_branch_spacing_boost)),
-                    new_node.circle.radius/radius_shrink_factor
-                };
-
-                new_branch.color = (SDL_Color){new_node.color.r*color_darken_factor, new_node.color.g*color_darken_factor, new_node.color.b*color_darken_factor, new_node.color.a};
-
-                new_branch.collision_grid.x = new_branch.circle.center.x / COLLISION_GRID_X;
-                new_branch.collision_grid.y = new_branch.circle.center.y / COLLISION_GRID_Y;
-
-                nodes_to_add[nodes_to_add_count] = new_branch;
-                nodes_to_add_count += 1;
-            }
-        }
-
-        // Add the new nodes into the graph.
-        graph->active_point_count = nodes_to_add_count;
-        for (int i = 0; i < nodes_to_add_count; i += 1)
-        {
-            graph->nodes[graph->node_count] = nodes_to_add[i];
-            graph->node_count += 1;
-        }
-    }
-
-    return;
-}
-
-void get_input(UI *ui, Graph *graph, SDL_Renderer *ren)
-{
-    // Handle events.
-    SDL_Event event;
-
-    while (SDL_PollEvent(&event))
-    {
-        switch (event.type)
-        {
-            case SDL_KEYDOWN:
-                switch (event.key.keysym.sym)
-                {
-                    case SDLK_ESCAPE:
-                        ui->quit = true;
-                        break;
-
-                    case SDLK_SPACE:
-                        ui->do_iteration = true;
-                        break;
-
-                    case SDLK_TAB:
-                        ui->show = !ui->show;
-                        break;
-                    
-                    case SDLK_f:
-                        ui->render_intermediate= !ui->render_intermediate;
-                        break;
-
-                    case SDLK_UP:
-                        graph->initial_point_count += 1;
-                        break;
-
-                    case SDLK_DOWN:
-                        if (graph->initial_point_count > 0)
-                        {
-                            graph->initial_point_count -= 1;
-                        }
-                        break;
-
-                    default:
-                        break;
-                }
-                break;
-
-            case SDL_QUIT:
-                ui->quit = true;
-                break;
-
-            default:
-                break;
-        }
-    }
-}
-
-int main(int argc, char *argv[])
-{
-	SDL_Init(SDL_INIT_EVERYTHING);
-    IMG_Init(IMG_INIT_PNG);
-
-    if (SDL_Init(SDL_INIT_VIDEO) != 0)
-    {
-        printf("SDL_Init video error: %s\n", SDL_GetError());
-        return 1;
-    }
-
-    if (SDL_Init(SDL_INIT_AUDIO) != 0)
-    {
-        printf("SDL_Init audio error: %s\n", SDL_GetError());
-        return 1;
-    }
-
-    // SDL_ShowCursor(SDL_DISABLE);
-
-	// Setup window
-	SDL_Window *win = SDL_CreateWindow("Hyphae",
-			SDL_WINDOWPOS_CENTERED,
-			SDL_WINDOWPOS_CENTERED,
-			1440, 980,
-			SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
-
-	// Setup renderer
-	SDL_Renderer *ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-
-	// Setup font
-	TTF_Init();
-	TTF_Font *font = TTF_OpenFont("liberation.ttf", 12);
-	if (!font)
-	{
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error: Font", TTF_GetError(), win);
-		return -666;
-	}
-
-    // Setup main loop
-    srand(time(NULL));
-    bool quit = false;
-    bool do_iteration = true;
-
-    Graph graph;
-#ifdef NODES_ON_HEAP
-    graph.nodes = malloc(sizeof(Node) * MAX_NODES);
-#endif
-    graph.node_count = 0;
-    graph.max_nodes = MAX_NODES;
-    graph.initial_point_count = 3;
-
-    UI ui;
-    ui.font = font;
-    ui.font_color = (SDL_Color){255, 255, 255, 255};
-    ui.show = true;
-    ui.quit = false;
-    ui.do_iteration = true;
-    ui.frames = 0;
-    ui.render_intermediate = true;
-
-    int nodes_last_frame = 0;
-    int nodes_this_frame = 0;
-    int nodes_added_this_frame = 0;
-
-    // Main loop
-    const float FPS_INTERVAL = 1.0f;
-    Uint64 fps_start, fps_current, fps_frames = 0;
-
-    fps_start = SDL_GetTicks();
-
-    while (!ui.quit)
-    {
-        SDL_PumpEvents();
-        get_input(&ui, &graph, ren);
-
-        if (!ui.quit)
-        {
-            SDL_GetWindowSize(win, &graph.window.x, &graph.window.y);
-
-            update(&ui, &graph);
-            nodes_last_frame = nodes_this_frame;
-            nodes_this_frame = graph.node_count;
-            nodes_added_this_frame = nodes_this_frame - nodes_last_frame;
-
-#ifdef RENDER_ADDITIVE
-            render_additive(ren, graph, ui, nodes_added_this_frame);
-#else
-            render(ren, graph, ui);
-#endif
-
-            fps_frames++;
-
-            if (fps_start < SDL_GetTicks() - FPS_INTERVAL * 1000)
-            {
-                fps_start = SDL_GetTicks();
-                fps_current = fps_frames;
-                fps_frames = 0;
-
-                ui.frames = fps_current;
-                // printf("%I64d fps\n", fps_current);
-            }
-        }
-    }
-
-	SDL_DestroyRenderer(ren);
-	SDL_DestroyWindow(win);
-	SDL_Quit();
-    return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <stdbool.h>
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "SDL_image.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#endif
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "memory.h"
+#include "vec2.h"
+#include "draw.h"
+#include "text.h"
+#include "perf.h"
+#include "timing.h"
+#include "histogram.h"
+#include "trace.h"
+#include "metrics.h"
+#include "pages.h"
+#include "grid.h"
+#include "genome.h"
+#include "graph.h"
+#include "queue.h"
+#include "dump.h"
+#include "deflate.h"
+#include "png.h"
+#include "export.h"
+#include "svg.h"
+#include "stream.h"
+#include "checkpoint.h"
+#include "golden.h"
+
+// Offscreen target that nodes are accumulated into. It is only ever appended to,
+// except when it has to be rebuilt from scratch.
+typedef struct {
+    SDL_Texture *texture;
+    int w;
+    int h;
+    int drawn_count;
+} Canvas;
+
+// World position at the top left of the window, and how many pixels a world unit covers.
+typedef struct {
+    vec2 offset;
+    int zoom_level;
+    float zoom;
+    bool dragging;
+
+    int *visible;
+    int visible_capacity;
+} Camera;
+
+#define CAMERA_ZOOM_STEP 1.25
+#define CAMERA_MIN_ZOOM_LEVEL -10
+#define CAMERA_MAX_ZOOM_LEVEL 20
+
+#ifdef PHASE_TIMING
+#define UI_LINE_COUNT 13
+#else
+#define UI_LINE_COUNT 11
+#endif
+#define UI_TIMELINE_HEIGHT 6
+
+typedef struct {
+    Canvas canvas;
+    bool redraw;
+    Camera camera;
+
+    // Generation being looked at, or 0 to follow the newest one.
+    int seek_generation;
+    bool seeking;
+
+    TTF_Font *font;
+    Glyph_Atlas atlas;
+    Text_Line lines[UI_LINE_COUNT];
+    SDL_Color font_color;
+    bool show;
+    bool quit;
+    bool render_intermediate;
+    bool dirty;
+    Uint64 frames;
+
+    // This frame's render() phases, and the update() phases of the generations drained for it.
+    Phase_Times render_times;
+    Phase_Times frame_update_times;
+    int frame_generation_count;
+
+    // What the overlay shows, rolled over with the fps counter.
+    Phase_Average render_average;
+    Phase_Average update_average;
+
+    // Every frame since the window opened, and every generation of this run.
+    Histogram frame_times;
+    Histogram generation_times;
+
+    // Where to put a span per frame, if anywhere.
+    Trace *trace;
+} UI;
+
+// Everything shared between the simulation thread and the render thread.
+// The graph belongs to the simulation thread; the render thread only reads
+// nodes that have come through the committed queue for the current run.
+typedef struct {
+    Graph graph;
+    int run;
+
+    Range_Queue committed;
+    SDL_atomic_t requested_run;
+    SDL_atomic_t initial_point_count;
+    SDL_atomic_t window_x;
+    SDL_atomic_t window_y;
+    SDL_atomic_t quit;
+
+    // Wakes the simulation thread when it's idle.
+    SDL_sem *wake;
+
+    // Wakes the render thread when it's idle. Only one is kept in flight.
+    Uint32 committed_event;
+    SDL_atomic_t committed_event_pending;
+} Simulation;
+
+void update_canvas(SDL_Renderer *renderer, Graph graph, UI *ui)
+{
+    Canvas *canvas = &ui->canvas;
+
+    // Grow the canvas if the window has outgrown it.
+    if (!canvas->texture || canvas->w < graph.window.x || canvas->h < graph.window.y)
+    {
+        if (canvas->texture)
+        {
+            SDL_DestroyTexture(canvas->texture);
+            memory_count(MEMORY_TEXTURES, -(Sint64)canvas->w * canvas->h * 4);
+        }
+
+        canvas->w = graph.window.x > canvas->w ? graph.window.x : canvas->w;
+        canvas->h = graph.window.y > canvas->h ? graph.window.y : canvas->h;
+        canvas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, canvas->w, canvas->h);
+        if (canvas->texture) memory_count(MEMORY_TEXTURES, (Sint64)canvas->w * canvas->h * 4);
+        ui->redraw = true;
+    }
+
+    SDL_SetRenderTarget(renderer, canvas->texture);
+
+    if (ui->redraw || canvas->drawn_count > graph.node_count)
+    {
+        // Set background color.
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+
+        canvas->drawn_count = 0;
+        ui->redraw = false;
+    }
+
+    // Draw new nodes. The simulation marks the newest ones as spawned while this runs, so only
+    // the fields it never changes once they're committed are read.
+    for (int i = canvas->drawn_count; i < graph.node_count; i += 1)
+    {
+        Node *node = graph_node(&graph, i);
+        draw_circle(renderer, node->circle, node->color);
+    }
+    canvas->drawn_count = graph.node_count;
+
+    SDL_SetRenderTarget(renderer, NULL);
+}
+
+// Copy the part of the canvas under the camera at 1:1, clipping both rects together.
+void render_canvas(SDL_Renderer *renderer, Graph graph, UI *ui)
+{
+    Canvas *canvas = &ui->canvas;
+
+    SDL_Rect source = {(int)floor(ui->camera.offset.x + 0.5), (int)floor(ui->camera.offset.y + 0.5), graph.window.x, graph.window.y};
+    SDL_Rect destination = {0, 0, graph.window.x, graph.window.y};
+
+    if (source.x < 0) { destination.x -= source.x; source.w += source.x; source.x = 0; }
+    if (source.y < 0) { destination.y -= source.y; source.h += source.y; source.y = 0; }
+    if (source.x + source.w > canvas->w) source.w = canvas->w - source.x;
+    if (source.y + source.h > canvas->h) source.h = canvas->h - source.y;
+    if (source.w <= 0 || source.h <= 0) return;
+
+    destination.w = source.w;
+    destination.h = source.h;
+    SDL_RenderCopy(renderer, canvas->texture, &source, &destination);
+}
+
+// Draw the nodes in the grid cells under the camera straight to the window, at the camera's scale.
+void render_zoomed(SDL_Renderer *renderer, Graph graph, UI *ui)
+{
+    Camera *camera = &ui->camera;
+
+    // Nodes stick out of their cell by up to a radius, so look one cell further in every direction.
+    // The nodes come back in the order they were committed, so overlaps look the same as on the canvas.
+    int visible_count = grid_gather(&graph.grid,
+        (int)floor(camera->offset.x / COLLISION_GRID_X) - 1,
+        (int)floor(camera->offset.y / COLLISION_GRID_Y) - 1,
+        (int)floor((camera->offset.x + graph.window.x / camera->zoom) / COLLISION_GRID_X) + 1,
+        (int)floor((camera->offset.y + graph.window.y / camera->zoom) / COLLISION_GRID_Y) + 1,
+        &camera->visible, &camera->visible_capacity);
+    PHASE_LAP(&ui->render_times, PHASE_SORT);
+
+    // Nodes from after the generation being looked at are still in the grid, but they sort to the end.
+    while (visible_count > 0 && camera->visible[visible_count - 1] >= graph.node_count) visible_count -= 1;
+
+    for (int i = 0; i < visible_count; i += 1)
+    {
+        Node *node = graph_node(&graph, camera->visible[i]);
+        vec2 center = vec2_scalar_multiply(vec2_subtract(node->circle.center, camera->offset), camera->zoom);
+        draw_disc(renderer, center, node->circle.radius * camera->zoom, node->color);
+    }
+}
+
+void set_collision_text(Text_Line *line, Glyph_Atlas *atlas, int y, const char *label, Collision_Counts *counts)
+{
+    // Seven counts as big as they can get and the words between them come to 210 characters, so this always fits a line.
+    set_text(line, atlas, 5, y, "%s: %llu tried, %llu off screen, skipped %llu far/%llu branch/%llu id, %llu tests, %llu hits",
+        label, (unsigned long long)counts->candidates, (unsigned long long)counts->off_screen, (unsigned long long)counts->far_cells,
+        (unsigned long long)counts->same_branch, (unsigned long long)counts->close_ids, (unsigned long long)counts->circle_tests,
+        (unsigned long long)counts->hits);
+}
+
+void render(SDL_Renderer *renderer, Graph graph, UI *ui)
+{
+    // Nodes are only ever appended, so an earlier generation is just fewer of them.
+    // Seeking back redraws the canvas from scratch; seeking forward only draws what's been skipped.
+    int shown_generation = ui->seek_generation > 0 ? ui->seek_generation : graph.generation;
+    graph.node_count = graph_generation_end(&graph, shown_generation);
+
+    Uint64 frame_start = ui->trace ? SDL_GetPerformanceCounter() : 0;
+    PHASE_START(&ui->render_times);
+
+    update_canvas(renderer, graph, ui);
+
+    // Set background color.
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    if (ui->render_intermediate)
+    {
+        // Draw nodes.
+        if (ui->camera.zoom_level == 0)
+        {
+            render_canvas(renderer, graph, ui);
+        }
+        else
+        {
+            render_zoomed(renderer, graph, ui);
+        }
+    }
+    PHASE_LAP(&ui->render_times, PHASE_DRAW);
+
+    if (ui->show)
+    {
+        // Draw UI.
+        set_text(&ui->lines[0], &ui->atlas, 5, 5 + 12*0, "%d initial points (up/down to change)", graph.initial_point_count);
+        set_text(&ui->lines[1], &ui->atlas, 5, 5 + 12*1, "%d/%d points (%d active)", graph.node_count, graph.max_nodes, graph.active_point_count);
+        set_text(&ui->lines[2], &ui->atlas, 5, 5 + 12*2, "%llu fps", (unsigned long long)ui->frames);
+        set_text(&ui->lines[3], &ui->atlas, 5, 5 + 12*3, "intermediate rendering %s (f to toggle)", ui->render_intermediate ? "on" : "off");
+        set_text(&ui->lines[4], &ui->atlas, 5, 5 + 12*4, "zoom %.2fx (wheel to zoom, drag to pan, r to reset)", ui->camera.zoom);
+        set_text(&ui->lines[5], &ui->atlas, 5, 5 + 12*5, "generation %d/%d%s (left/right or drag the bar to seek, end to follow)",
+            shown_generation, graph.generation, ui->seek_generation > 0 ? "" : " (following)");
+        set_collision_text(&ui->lines[6], &ui->atlas, 5 + 12*6, "this gen", &graph.collisions);
+        set_collision_text(&ui->lines[7], &ui->atlas, 5 + 12*7, "this run", &graph.total_collisions);
+        set_text(&ui->lines[8], &ui->atlas, 5, 5 + 12*8, "ms p50/p90/p99/max: frame %.1f/%.1f/%.1f/%.1f, generation %.2f/%.2f/%.2f/%.2f",
+            histogram_percentile(&ui->frame_times, 50), histogram_percentile(&ui->frame_times, 90),
+            histogram_percentile(&ui->frame_times, 99), histogram_max(&ui->frame_times),
+            histogram_percentile(&ui->generation_times, 50), histogram_percentile(&ui->generation_times, 90),
+            histogram_percentile(&ui->generation_times, 99), histogram_max(&ui->generation_times));
+        Memory_Counts memory = memory_snapshot();
+        set_text(&ui->lines[9], &ui->atlas, 5, 5 + 12*9, "memory %.1f MB (peak %.1f): nodes %.1f, branches %.1f, grid %.1f, frontier %.1f, scratch %.1f, textures %.1f, framebuffers %.1f",
+            memory_megabytes(memory.total), memory_megabytes(memory.total_peak), memory_megabytes(memory.current[MEMORY_NODES]),
+            memory_megabytes(memory.current[MEMORY_BRANCHES]), memory_megabytes(memory.current[MEMORY_GRID]),
+            memory_megabytes(memory.current[MEMORY_FRONTIER]), memory_megabytes(memory.current[MEMORY_SCRATCH]), memory_megabytes(memory.current[MEMORY_TEXTURES]), memory_megabytes(memory.current[MEMORY_FRAMEBUFFERS]));
+#ifdef PHASE_TIMING
+        double *update_ms = ui->update_average.milliseconds;
+        double *render_ms = ui->render_average.milliseconds;
+        set_text(&ui->lines[10], &ui->atlas, 5, 5 + 12*10, "update %.2f ms/gen: init %.2f, candidates %.2f, bounds %.2f, collision %.2f, spawn %.2f, commit %.2f",
+            phase_total_milliseconds(update_ms, PHASE_INIT, PHASE_COMMIT), update_ms[PHASE_INIT], update_ms[PHASE_CANDIDATES],
+            update_ms[PHASE_BOUNDS], update_ms[PHASE_COLLISION], update_ms[PHASE_SPAWN], update_ms[PHASE_COMMIT]);
+        set_text(&ui->lines[11], &ui->atlas, 5, 5 + 12*11, "render %.2f ms/frame: sort %.2f, draw %.2f, text %.2f, present %.2f",
+            phase_total_milliseconds(render_ms, PHASE_SORT, PHASE_PRESENT), render_ms[PHASE_SORT], render_ms[PHASE_DRAW],
+            render_ms[PHASE_TEXT], render_ms[PHASE_PRESENT]);
+#endif
+        set_text(&ui->lines[UI_LINE_COUNT - 1], &ui->atlas, 5, 5 + 12*(UI_LINE_COUNT - 1), "(tab to show/hide)");
+
+        for (int i = 0; i < UI_LINE_COUNT; i += 1)
+        {
+            draw_text(renderer, &ui->atlas, &ui->lines[i], ui->font_color);
+        }
+
+        // Timeline along the bottom, filled up to the generation being looked at.
+        if (graph.generation > 0)
+        {
+            SDL_Rect bar = {0, graph.window.y - UI_TIMELINE_HEIGHT, graph.window.x, UI_TIMELINE_HEIGHT};
+            SDL_SetRenderDrawColor(renderer, 48, 48, 48, 255);
+            SDL_RenderFillRect(renderer, &bar);
+
+            bar.w = (int)((Sint64)graph.window.x * shown_generation / graph.generation);
+            SDL_SetRenderDrawColor(renderer, ui->font_color.r, ui->font_color.g, ui->font_color.b, 255);
+            SDL_RenderFillRect(renderer, &bar);
+        }
+    }
+    PHASE_LAP(&ui->render_times, PHASE_TEXT);
+
+    SDL_RenderPresent(renderer);
+    PHASE_LAP(&ui->render_times, PHASE_PRESENT);
+
+    if (ui->trace)
+    {
+        trace_span(ui->trace, "render", "frame", frame_start, SDL_GetPerformanceCounter(), shown_generation, graph.node_count);
+#ifdef PHASE_TIMING
+        trace_phases(ui->trace, "render", frame_start, &ui->render_times, PHASE_SORT, PHASE_PRESENT, shown_generation);
+#endif
+    }
+
+#ifdef PHASE_TIMING
+    phase_average_add(&ui->render_average, &ui->render_times);
+#endif
+}
+
+// Whether new_node would go off the screen or run into another branch.
+bool node_collides(Graph *graph, Node *new_node)
+{
+    // Make sure this node didn't go off the screen.
+    bool off_screen = new_node->circle.center.x < 0 || new_node->circle.center.y < 0 ||
+        new_node->circle.center.x > graph->window.x || new_node->circle.center.y > graph->window.y;
+    PHASE_LAP(&graph->phase_times, PHASE_BOUNDS);
+    if (off_screen)
+    {
+        graph->collisions.off_screen += 1;
+        return true;
+    }
+
+    // Nodes passed over for being in a far cell are whatever's left of those scanned.
+    int scanned = graph->node_count;
+    int same_branch = 0;
+    int close_ids = 0;
+    int circle_tests = 0;
+    bool collided = false;
+
+    // A page at a time, rather than looking each node up.
+    for (int start = 0; start < graph->node_count && !collided; start += PAGE_ITEMS)
+    {
+        Node *page = graph_node(graph, start);
+        int count = graph->node_count - start < PAGE_ITEMS ? graph->node_count - start : PAGE_ITEMS;
+
+        for (int j = 0; j < count; j += 1)
+        {
+            Node *node = &page[j];
+
+            // Check collision_grid coordinates.
+            int x_coordinate_difference = abs(new_node->collision_grid.x - node->collision_grid.x);
+            int y_coordinate_difference = abs(new_node->collision_grid.y - node->collision_grid.y);
+            if (x_coordinate_difference > 1 || y_coordinate_difference > 1) continue; 
+
+            // We don't care about collisions with our own branch.
+            if (new_node->branch == node->branch)
+            {
+                same_branch += 1;
+                continue;
+            }
+
+            // We don't care about collisions with nodes spawned very near the same time as us.
+            if (abs(new_node->id - node->id) < 60)
+            {
+                close_ids += 1;
+                continue;
+            }
+
+            // TODO(bkaylor): Add more ways to ignore nodes.
+
+            circle_tests += 1;
+            if (do_circles_collide(new_node->circle, node->circle))
+            {
+                collided = true;
+                scanned = start + j + 1;
+                break;
+            }
+        }
+    }
+
+    Collision_Counts *counts = &graph->collisions;
+    counts->far_cells += scanned - same_branch - close_ids - circle_tests;
+    counts->same_branch += same_branch;
+    counts->close_ids += close_ids;
+    counts->circle_tests += circle_tests;
+    if (collided) counts->hits += 1;
+
+    return collided;
+}
+
+// The same answer as node_collides, from only the nodes filed in the grid cells around new_node's,
+// and without counting anything. It's what differential runs check the full scan against.
+bool node_collides_in_grid(Graph *graph, Node *new_node, int **indices, int *capacity)
+{
+    bool off_screen = new_node->circle.center.x < 0 || new_node->circle.center.y < 0 ||
+        new_node->circle.center.x > graph->window.x || new_node->circle.center.y > graph->window.y;
+    if (off_screen) return true;
+
+    int x = new_node->collision_grid.x;
+    int y = new_node->collision_grid.y;
+    int count = grid_gather(&graph->grid, x - 1, y - 1, x + 1, y + 1, indices, capacity);
+
+    for (int i = 0; i < count; i += 1)
+    {
+        Node *node = graph_node(graph, (*indices)[i]);
+
+        // Cells are clamped onto the grid's edge, so the neighbours gathered can still be too far.
+        if (abs(new_node->collision_grid.x - node->collision_grid.x) > 1 || abs(new_node->collision_grid.y - node->collision_grid.y) > 1) continue;
+        if (new_node->branch == node->branch) continue;
+        if (abs(new_node->id - node->id) < 60) continue;
+
+        if (do_circles_collide(new_node->circle, node->circle)) return true;
+    }
+
+    return false;
+}
+
+void publish_metrics(Graph *graph)
+{
+    // Only this thread writes the sample, so it can read back the last one.
+    Metrics_Sample sample = graph->metrics->sample;
+    sample.published = SDL_GetPerformanceCounter();
+
+    // A run's rate is counted from the start of its first generation here, whether that's
+    // the first of a new run or the first after resuming. Every active point was just added.
+    if (graph->starting_new || sample.run_start == 0)
+    {
+        sample.run_start = sample.published - graph->generation_ticks;
+        sample.run_start_node_count = graph->node_count - graph->active_point_count;
+    }
+
+    sample.generation = graph->generation;
+    sample.node_count = graph->node_count;
+    sample.active_point_count = graph->active_point_count;
+    sample.max_nodes = graph->max_nodes;
+    sample.generation_ticks = graph->generation_ticks;
+    for (int i = 0; i < PHASE_FIRST_RENDER; i += 1)
+    {
+        sample.phase_ticks[i] = graph->phase_times.ticks[i];
+    }
+
+    metrics_publish(graph->metrics, &sample);
+}
+
+// Roll a sides-sided die and check it comes up under chance, unless the graph is
+// replaying a genome, in which case the outcome comes from there. Either way the
+// outcome goes into the genome being recorded, if there is one.
+bool decide(Graph *graph, int model, int sides, float chance)
+{
+    bool outcome = graph->replay ? genome_read(graph->replay, model) : graph_random(graph) % sides < chance;
+    if (graph->record) genome_write(graph->record, model, outcome);
+
+    return outcome;
+}
+
+int frontier_compare(const void *a, const void *b)
+{
+    const Frontier_Node *n1 = a;
+    const Frontier_Node *n2 = b;
+
+    if (n1->x < n2->x) return -1;
+    if (n1->x > n2->x) return 1;
+
+    // Ties go the way they were committed, so every platform's qsort agrees.
+    return n1->index - n2->index;
+}
+
+// Fill the graph's frontier with the nodes that haven't spawned yet, sorted by x coordinate. Returns how many.
+// Nodes try to continue in this order, which decides their ids and how the generator's numbers are handed out.
+int gather_frontier(Graph *graph)
+{
+    int count = 0;
+    for (int i = 0; i < graph->node_count; i += 1)
+    {
+        Node *node = graph_node(graph, i);
+        if (node->has_spawned) continue;
+
+        if (count == graph->frontier_capacity)
+        {
+            int capacity = graph->frontier_capacity ? graph->frontier_capacity * 2 : 1024;
+            graph->frontier = memory_realloc(MEMORY_FRONTIER, graph->frontier, sizeof(Frontier_Node) * graph->frontier_capacity, sizeof(Frontier_Node) * capacity);
+            graph->frontier_capacity = capacity;
+        }
+
+        graph->frontier[count].x = node->circle.center.x;
+        graph->frontier[count].index = i;
+        count += 1;
+    }
+
+    qsort(graph->frontier, count, sizeof(Frontier_Node), frontier_compare);
+    return count;
+}
+
+void update(Graph *graph) 
+{
+    // CONSTANTS
+    float initial_spacing = 14;
+    float initial_jitter = 0.002;
+    float initial_radius = 14;
+
+    int color_min = 56;
+    int color_range= 256 - color_min;
+
+    float radius_shrink_factor = 1.5;
+    float jitter_growth_factor = 1.2;
+    float color_darken_factor = 0.95;
+
+    float new_branch_spacing_boost = 2.5;
+    float new_branch_smallest_radius = 2.0;
+
+    float chance_to_spawn_new_branch = graph->spawn_chance;
+
+    /* Experimenting
+    float initial_radius = 20;
+    float initial_spacing = initial_radius;
+    float initial_jitter = 0.0025;
+
+    int color_min = 40;
+    int color_range= 256 - color_min;
+
+    float radius_shrink_factor = 1.5;
+    float jitter_growth_factor = 1.2;
+    float color_darken_factor = 0.9;
+
+    float new_branch_spacing_boost = 1.7;
+    float new_branch_smallest_radius = 2.0;
+
+    float chance_to_spawn_new_branch = 2.0;
+    */
+
+    Uint64 generation_start = SDL_GetPerformanceCounter();
+    PHASE_START(&graph->phase_times);
+    memset(&graph->collisions, 0, sizeof(Collision_Counts));
+
+    graph->starting_new = false;
+
+    if (graph->do_iteration)
+    {
+        // Zero out the graph.
+        graph_reset(graph);
+
+        float initial_spacing = 12;
+        float initial_jitter = 0.0015;
+        float initial_radius = 14;
+
+        // TODO(bkaylor): Should initial nodes' directions always be away from the center?
+
+        for (int i = 0; i < graph->initial_point_count; i += 1)
+        {
+            Node initial_node;
+            initial_node.circle = (Circle){{((i+1) * graph->window.x/(graph->initial_point_count+1)), graph->window.y/2}, initial_radius};
+            initial_node.has_spawned = false;
+            initial_node.parent = -1;
+            initial_node.branch = graph->next_branch;
+            initial_node.jitter = initial_jitter;
+            initial_node.spacing = initial_spacing;
+
+            if (graph->replay)
+            {
+                initial_node.direction = graph->replay->directions[i];
+                initial_node.color = graph->replay->colors[i];
+            }
+            else
+            {
+                initial_node.direction = (float)(graph_random(graph) % 360);
+                initial_node.color = (SDL_Color){(graph_random(graph)%color_range) + color_min, (graph_random(graph)%color_range) + color_min, (graph_random(graph)%color_range) + color_min, 255};
+
+                // Hardcode colors here if needed!
+#if 0
+                if (i == 0) {
+                    initial_node.color = (SDL_Color){140, 26, 39, 255};
+                }
+                if (i == 1) {
+                    initial_node.color = (SDL_Color){59, 101, 67, 255};
+                }
+                if (i == 2) {
+                    initial_node.color = (SDL_Color){245, 245, 245, 255};
+                }
+#else
+                if (i == 0) {
+                    initial_node.color = (SDL_Color){248, 200, 220, 255};
+                }
+                if (i == 1) {
+                    initial_node.color = (SDL_Color){255, 255, 255, 255};
+                }
+                if (i == 2) {
+                    initial_node.color = (SDL_Color){167, 199, 231, 255};
+                }
+#endif
+            }
+
+            if (graph->record) genome_set_initial(graph->record, i, initial_node.direction, initial_node.color);
+
+            initial_node.collision_grid.x = initial_node.circle.center.x / COLLISION_GRID_X;
+            initial_node.collision_grid.y = initial_node.circle.center.y / COLLISION_GRID_Y;
+
+            graph->next_branch += 1;
+
+            graph_commit(graph, initial_node);
+        }
+
+        graph->do_iteration = false;
+        graph->starting_new = true;
+    }
+
+    if (!graph->starting_new && graph->active_point_count < 1) return; 
+
+#ifdef NODES_ON_HEAP
+    // A generation can add at most as many nodes as the cap has room for. That's most for a run's first
+    // generation, so the buffer is only grown then.
+    int room = graph->max_nodes - graph->node_count + 1;
+    if (room > graph->nodes_to_add_capacity)
+    {
+        graph->nodes_to_add = memory_realloc(MEMORY_SCRATCH, graph->nodes_to_add, sizeof(Node) * graph->nodes_to_add_capacity, sizeof(Node) * room);
+        graph->nodes_to_add_capacity = room;
+    }
+    Node *nodes_to_add = graph->nodes_to_add;
+#else
+    Node nodes_to_add[MAX_NODES];
+#endif
+
+    int nodes_to_add_count = 0;
+
+    if (graph->node_count < graph->max_nodes)
+    {
+        // Sort nodes by x coordinate.
+        int frontier_count = gather_frontier(graph);
+        PHASE_LAP(&graph->phase_times, PHASE_INIT);
+
+        for (int f = 0; f < frontier_count; f += 1)
+        {
+            if (graph->node_count + nodes_to_add_count >= graph->max_nodes) break;
+
+            // It's about to be marked as spawned, so it needs to be on a page of our own.
+            int i = graph->frontier[f].index;
+            Node *node = graph_edit_node(graph, i);
+
+            // Continue the branch by trying to add a new node.
+            bool heads = decide(graph, GENOME_HEADS, 2, 1);
+
+            Node new_node;
+            new_node.has_spawned = false;
+            new_node.parent = i;
+            new_node.branch = node->branch;
+
+            new_node.id = graph->next_id;
+            graph->next_id += 1;
+
+            new_node.direction = node->direction + (heads ? node->jitter : (node->jitter * -1));
+            new_node.jitter = node->jitter;
+            new_node.spacing = node->spacing;
+            new_node.circle = (Circle){
+                vec2_add(node->circle.center, vec2_scalar_multiply(vec2_normalize(vec2_rotate((vec2){1, 0}, new_node.direction)), new_node.spacing)),
+                node->circle.radius
+            };
+            new_node.color = node->color;
+
+            new_node.collision_grid.x = new_node.circle.center.x / COLLISION_GRID_X;
+            new_node.collision_grid.y = new_node.circle.center.y / COLLISION_GRID_Y;
+
+            node->has_spawned = true;
+            graph->collisions.candidates += 1;
+            PHASE_LAP(&graph->phase_times, PHASE_CANDIDATES);
+
+            // Only add the node if it doesn't collide with another branch. A replay already knows whether it did.
+            int accepted_model = GENOME_ACCEPTED(new_node.circle.radius);
+            bool new_node_collided = graph->replay ? !genome_read(graph->replay, accepted_model) : node_collides(graph, &new_node);
+            if (graph->record) genome_write(graph->record, accepted_model, !new_node_collided);
+
+            Divergence *differential = graph->differential;
+            if (differential && !graph->replay && !differential->diverged)
+            {
+                differential->checked_count += 1;
+                if (node_collides_in_grid(graph, &new_node, &differential->indices, &differential->capacity) != new_node_collided)
+                {
+                    differential->diverged = true;
+                    differential->generation = graph->generation + 1;
+                    differential->node_index = graph->node_count + nodes_to_add_count;
+                    differential->parent = new_node.parent;
+                    differential->center = new_node.circle.center;
+                    differential->full_scan_collided = new_node_collided;
+                }
+            }
+            PHASE_LAP(&graph->phase_times, PHASE_COLLISION);
+
+            if (new_node_collided) continue;
+
+            // If we made it here, the new potential node is valid. Add it to the new nodes list!
+            nodes_to_add[nodes_to_add_count] = new_node;
+            nodes_to_add_count += 1;
+
+            // In addition to continuing existing branches, give each new node in a branch 
+            // a small chance to start a new, smaller branch.
+            // (As long as there's room for it: the new node may have just taken the last slot.)
+            if (graph->node_count + nodes_to_add_count < graph->max_nodes &&
+                (new_node.circle.radius > new_branch_smallest_radius) && decide(graph, GENOME_SPAWN(new_node.branch), 100, (new_node.branch+chance_to_spawn_new_branch)*chance_to_spawn_new_branch))
+            {
+                bool heads = decide(graph, GENOME_SPAWN_HEADS, 2, 1);
+
+                Node new_branch;
+                new_branch.has_spawned = false;
+
+                // It grows from the node just added above, which lands after everything already committed.
+                new_branch.parent = graph->node_count + nodes_to_add_count - 1;
+
+                new_branch.branch = graph->next_branch;
+                graph->next_branch += 1;
+
+                new_branch.id= graph->next_id;
+                graph->next_id += 1;
+
+                new_branch.jitter = new_node.jitter * jitter_growth_factor;
+                new_branch.spacing = new_node.spacing / radius_shrink_factor;
+                new_branch.direction = new_node.direction + (heads ? 1.5 : -1.5);
+                new_branch.circle = (Circle){
+                    vec2_add(new_node.circle.center, vec2_scalar_multiply(vec2_normalize(vec2_rotate((vec2){1, 0}, new_branch.direction)), new_branch.spacing*new_branch_spacing_boost)),
+                    new_node.circle.radius/radius_shrink_factor
+                };
+
+                new_branch.color = (SDL_Color){new_node.color.r*color_darken_factor, new_node.color.g*color_darken_factor, new_node.color.b*color_darken_factor, new_node.color.a};
+
+                new_branch.collision_grid.x = new_branch.circle.center.x / COLLISION_GRID_X;
+                new_branch.collision_grid.y = new_branch.circle.center.y / COLLISION_GRID_Y;
+
+                nodes_to_add[nodes_to_add_count] = new_branch;
+                nodes_to_add_count += 1;
+            }
+            PHASE_LAP(&graph->phase_times, PHASE_SPAWN);
+        }
+
+        // Add the new nodes into the graph.
+        graph->active_point_count = nodes_to_add_count;
+        for (int i = 0; i < nodes_to_add_count; i += 1)
+        {
+            graph_commit(graph, nodes_to_add[i]);
+        }
+        graph_end_generation(graph);
+        collision_counts_add(&graph->total_collisions, &graph->collisions);
+        PHASE_LAP(&graph->phase_times, PHASE_COMMIT);
+
+        Uint64 generation_end = SDL_GetPerformanceCounter();
+        graph->generation_ticks = generation_end - generation_start;
+
+        if (graph->trace)
+        {
+            trace_span(graph->trace, "update", "generation", generation_start, generation_end, graph->generation, graph->node_count);
+#ifdef PHASE_TIMING
+            trace_phases(graph->trace, "update", generation_start, &graph->phase_times, PHASE_INIT, PHASE_COMMIT, graph->generation);
+#endif
+        }
+    }
+    else
+    {
+        // Out of room, so nothing is left to grow.
+        graph->active_point_count = 0;
+    }
+
+    if (graph->metrics) publish_metrics(graph);
+
+    return;
+}
+
+int simulate(void *data)
+{
+    Simulation *sim = data;
+    Graph *graph = &sim->graph;
+
+    graph_seed(graph, (unsigned int)time(NULL));
+    if (graph->trace) trace_name_thread(graph->trace, "simulation");
+
+    while (!SDL_AtomicGet(&sim->quit))
+    {
+        int run = SDL_AtomicGet(&sim->requested_run);
+        if (run != sim->run)
+        {
+            sim->run = run;
+            graph->initial_point_count = SDL_AtomicGet(&sim->initial_point_count);
+            graph->do_iteration = true;
+        }
+
+        if (!graph->do_iteration && graph->active_point_count < 1)
+        {
+            // Nothing left to grow, so sleep until the render thread asks for a new run (or to quit).
+            SDL_SemWait(sim->wake);
+            continue;
+        }
+
+        graph->window.x = SDL_AtomicGet(&sim->window_x);
+        graph->window.y = SDL_AtomicGet(&sim->window_y);
+
+        int start = graph->node_count;
+        update(graph);
+        if (graph->starting_new) start = 0;
+
+        Committed_Range range = {run, start, graph->node_count, graph->active_point_count, graph->generation, graph->phase_times, graph->generation_ticks, graph->collisions};
+        while (!range_queue_push(&sim->committed, range))
+        {
+            // The render thread is behind. Wait for room unless the range is already stale.
+            if (SDL_AtomicGet(&sim->quit) || SDL_AtomicGet(&sim->requested_run) != run) break;
+            SDL_Delay(1);
+        }
+
+        if (SDL_AtomicCAS(&sim->committed_event_pending, 0, 1))
+        {
+            SDL_Event event = {0};
+            event.type = sim->committed_event;
+            SDL_PushEvent(&event);
+        }
+    }
+
+    return 0;
+}
+
+#ifdef SIGUSR1
+volatile sig_atomic_t checkpoint_requested = 0;
+
+void request_checkpoint(int signal_number)
+{
+    (void)signal_number;
+    checkpoint_requested = 1;
+}
+#endif
+
+void print_perf_row(Perf_Counters *perf, int phase, const char *name, int node_count)
+{
+    Uint64 *counts = perf->totals[phase];
+    double per_node = node_count > 0 ? 1.0 / node_count : 0;
+    double ipc = counts[PERF_CYCLES] > 0 ? (double)counts[PERF_INSTRUCTIONS] / counts[PERF_CYCLES] : 0;
+
+    printf("%-12s %14llu %14llu %6.2f %12.2f %12.2f %12.2f\n", name,
+        (unsigned long long)counts[PERF_CYCLES], (unsigned long long)counts[PERF_INSTRUCTIONS], ipc,
+        counts[PERF_L1D_MISSES] * per_node, counts[PERF_LLC_MISSES] * per_node, counts[PERF_BRANCH_MISSES] * per_node);
+}
+
+// A table of what the counters came to in each phase of growth and export, with misses per node of the finished diagram.
+void print_perf_counters(Perf_Counters *update_perf, Perf_Counters *export_perf, int node_count)
+{
+    printf("%-12s %14s %14s %6s %12s %12s %12s\n", "phase", "cycles", "instructions", "IPC", "L1D/node", "LLC/node", "branch/node");
+    for (int phase = PHASE_INIT; phase <= PHASE_COMMIT; phase += 1)
+    {
+        print_perf_row(update_perf, phase, phase_names[phase], node_count);
+    }
+
+    if (export_perf->laps[EXPORT_PERF_RASTER] > 0)
+    {
+        print_perf_row(export_perf, EXPORT_PERF_RASTER, "raster", node_count);
+        print_perf_row(export_perf, EXPORT_PERF_ENCODE, "encode", node_count);
+    }
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i += 1)
+    {
+        if (!update_perf->opened[i]) printf("(no %s counter here, so those are 0)\n", perf_counter_names[i]);
+    }
+}
+
+// One line of percentiles for the final stats, like "generation time: p50 1.20 ms, ... (499 generations)".
+void print_histogram(const char *label, Histogram *histogram, const char *counted)
+{
+    printf("%s time: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms (%llu %s)\n", label,
+        histogram_percentile(histogram, 50), histogram_percentile(histogram, 90), histogram_percentile(histogram, 99),
+        histogram_max(histogram), (unsigned long long)histogram->total, counted);
+}
+
+// What each category of tracked memory holds now and held at most.
+void print_memory(void)
+{
+    Memory_Counts memory = memory_snapshot();
+
+    printf("%-14s %10s %10s\n", "memory (MB)", "now", "peak");
+    for (int i = 0; i < MEMORY_CATEGORY_COUNT; i += 1)
+    {
+        printf("%-14s %10.2f %10.2f\n", memory_category_names[i], memory_megabytes(memory.current[i]), memory_megabytes(memory.peak[i]));
+    }
+    printf("%-14s %10.2f %10.2f\n", "all", memory_megabytes(memory.total), memory_megabytes(memory.total_peak));
+}
+
+// One CSV row of collision counts, labelled with a generation or "total".
+void write_collision_row(FILE *file, const char *label, int node_count, Collision_Counts *counts)
+{
+    fprintf(file, "%s,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", label, node_count,
+        (unsigned long long)counts->candidates, (unsigned long long)counts->off_screen, (unsigned long long)counts->far_cells,
+        (unsigned long long)counts->same_branch, (unsigned long long)counts->close_ids, (unsigned long long)counts->circle_tests,
+        (unsigned long long)counts->hits);
+}
+
+// Grow until nothing's left to grow, sending each generation down stream as it's committed if there is one,
+// handing the checkpointer a snapshot whenever one's due, and logging each generation's phase times,
+// collision counts and duration if there's somewhere to.
+bool grow_headless(Graph *graph, Node_Stream *stream, Checkpointer *checkpointer, Phase_Log *log, FILE *stats, Histogram *generation_times)
+{
+    bool checkpoint_due = false;
+
+    do
+    {
+        int start = graph->do_iteration ? 0 : graph->node_count;
+        int generation = graph->generation;
+        update(graph);
+
+        // The call that finds the cap already reached commits no generation, so there's nothing of it to log.
+        bool committed = graph->generation > generation;
+        if (generation_times && committed) histogram_record_ticks(generation_times, graph->generation_ticks);
+
+        if (stream && graph->node_count > start && !stream_generation(stream, graph, start, graph->node_count)) return false;
+        if (log && committed) phase_log_write(log, 1, &graph->phase_times, NULL);
+
+        if (stats && committed)
+        {
+            char label[16];
+            snprintf(label, sizeof(label), "%d", graph->generation);
+            write_collision_row(stats, label, graph->node_count, &graph->collisions);
+        }
+
+        if (checkpointer)
+        {
+            if (checkpointer->every > 0 && graph->generation % checkpointer->every == 0) checkpoint_due = true;
+#ifdef SIGUSR1
+            if (checkpoint_requested)
+            {
+                checkpoint_requested = 0;
+                checkpoint_due = true;
+            }
+#endif
+
+            // If the last one's still being written, try again after the next generation.
+            if (checkpoint_due && checkpoint_take(checkpointer, graph)) checkpoint_due = false;
+        }
+    } while (graph->active_point_count > 0);
+
+    return true;
+}
+
+// Pull everything the simulation thread has committed into the render thread's view of the graph.
+void drain_committed(Simulation *sim, Graph *view, UI *ui)
+{
+    int run = SDL_AtomicGet(&sim->requested_run);
+
+    Committed_Range range;
+    while (range_queue_pop(&sim->committed, &range))
+    {
+        // Ranges from a run that's since been restarted point at nodes that are being overwritten.
+        if (range.run != run) continue;
+
+        if (range.start == 0)
+        {
+            view->node_count = 0;
+            view->generation = 0;
+            memset(&view->total_collisions, 0, sizeof(Collision_Counts));
+            histogram_reset(&ui->generation_times);
+            grid_reset(&view->grid, view->window.x / COLLISION_GRID_X + 1, view->window.y / COLLISION_GRID_Y + 1);
+            ui->redraw = true;
+        }
+
+        for (int i = range.start; i < range.end; i += 1)
+        {
+            Node *node = graph_node(view, i);
+            grid_add(&view->grid, node->collision_grid.x, node->collision_grid.y, i);
+        }
+
+        view->node_count = range.end;
+        view->active_point_count = range.active_point_count;
+
+        // Only ranges that end a generation were timed; the last update() of a run just finds nothing to grow.
+        if (range.generation > view->generation) histogram_record_ticks(&ui->generation_times, range.generation_ticks);
+
+        // The view keeps its own table of where each generation ended, for seeking.
+        while (view->generation < range.generation) graph_end_generation(view);
+
+        view->collisions = range.collisions;
+        collision_counts_add(&view->total_collisions, &range.collisions);
+
+#ifdef PHASE_TIMING
+        phase_average_add(&ui->update_average, &range.phase_times);
+        for (int i = 0; i < PHASE_FIRST_RENDER; i += 1)
+        {
+            ui->frame_update_times.ticks[i] += range.phase_times.ticks[i];
+        }
+        ui->frame_generation_count += 1;
+#endif
+
+        ui->dirty = true;
+    }
+
+    // Show the finished diagram even if intermediate rendering was off.
+    if (!ui->render_intermediate && view->active_point_count < 1)
+    {
+        ui->render_intermediate = true;
+    }
+}
+
+void start_new_run(Simulation *sim, Graph *view, UI *ui)
+{
+    // Stop looking at the old nodes straight away; the simulation thread is about to overwrite them.
+    view->node_count = 0;
+    view->active_point_count = 0;
+    view->generation = 0;
+    memset(&view->collisions, 0, sizeof(Collision_Counts));
+    memset(&view->total_collisions, 0, sizeof(Collision_Counts));
+    grid_reset(&view->grid, 1, 1);
+    ui->seek_generation = 0;
+    ui->redraw = true;
+
+    SDL_AtomicAdd(&sim->requested_run, 1);
+    SDL_SemPost(sim->wake);
+}
+
+// Look at generation, or go back to following the newest one if it's that or past it.
+void seek_to_generation(UI *ui, Graph *view, int generation)
+{
+    if (generation < 1) generation = 1;
+    ui->seek_generation = generation < view->generation ? generation : 0;
+}
+
+// Seek to wherever x is along the timeline.
+void seek_to_timeline(UI *ui, Graph *view, int x)
+{
+    if (view->window.x > 0) seek_to_generation(ui, view, (int)(((Sint64)x * view->generation + view->window.x / 2) / view->window.x));
+}
+
+void get_input(UI *ui, Simulation *sim, Graph *view, SDL_Renderer *ren)
+{
+    // Handle events.
+    SDL_Event event;
+
+    while (SDL_PollEvent(&event))
+    {
+        // Anything at all might change what's on screen.
+        ui->dirty = true;
+
+        if (event.type == sim->committed_event)
+        {
+            SDL_AtomicSet(&sim->committed_event_pending, 0);
+            continue;
+        }
+
+        switch (event.type)
+        {
+            case SDL_KEYDOWN:
+                switch (event.key.keysym.sym)
+                {
+                    case SDLK_ESCAPE:
+                        ui->quit = true;
+                        break;
+
+                    case SDLK_SPACE:
+                        start_new_run(sim, view, ui);
+                        break;
+
+                    case SDLK_TAB:
+                        ui->show = !ui->show;
+                        break;
+                    
+                    case SDLK_f:
+                        ui->render_intermediate= !ui->render_intermediate;
+                        break;
+
+                    case SDLK_UP:
+                        SDL_AtomicAdd(&sim->initial_point_count, 1);
+                        break;
+
+                    case SDLK_DOWN:
+                        if (SDL_AtomicGet(&sim->initial_point_count) > 0)
+                        {
+                            SDL_AtomicAdd(&sim->initial_point_count, -1);
+                        }
+                        break;
+
+                    case SDLK_r:
+                        ui->camera.offset = (vec2){0, 0};
+                        ui->camera.zoom_level = 0;
+                        ui->camera.zoom = 1;
+                        break;
+
+                    case SDLK_LEFT:
+                    case SDLK_RIGHT:
+                    {
+                        // Shift steps ten generations at a time.
+                        int step = (event.key.keysym.mod & KMOD_SHIFT) ? 10 : 1;
+                        int from = ui->seek_generation > 0 ? ui->seek_generation : view->generation;
+                        seek_to_generation(ui, view, event.key.keysym.sym == SDLK_LEFT ? from - step : from + step);
+                    } break;
+
+                    case SDLK_HOME:
+                        seek_to_generation(ui, view, 1);
+                        break;
+
+                    case SDLK_END:
+                        ui->seek_generation = 0;
+                        break;
+
+                    default:
+                        break;
+                }
+                break;
+
+            case SDL_MOUSEWHEEL:
+            {
+                Camera *camera = &ui->camera;
+
+                int zoom_level = camera->zoom_level + event.wheel.y;
+                if (zoom_level < CAMERA_MIN_ZOOM_LEVEL) zoom_level = CAMERA_MIN_ZOOM_LEVEL;
+                if (zoom_level > CAMERA_MAX_ZOOM_LEVEL) zoom_level = CAMERA_MAX_ZOOM_LEVEL;
+
+                // Zoom around the mouse, keeping the world point under it in place.
+                int mouse_x, mouse_y;
+                SDL_GetMouseState(&mouse_x, &mouse_y);
+                vec2 mouse = {mouse_x, mouse_y};
+                vec2 anchor = vec2_add(camera->offset, vec2_scalar_multiply(mouse, 1 / camera->zoom));
+
+                camera->zoom_level = zoom_level;
+                camera->zoom = pow(CAMERA_ZOOM_STEP, zoom_level);
+                camera->offset = vec2_subtract(anchor, vec2_scalar_multiply(mouse, 1 / camera->zoom));
+            } break;
+
+            case SDL_MOUSEBUTTONDOWN:
+                if (event.button.button != SDL_BUTTON_LEFT) break;
+
+                // The timeline is a little easier to hit than it looks.
+                if (ui->show && view->generation > 0 && event.button.y >= view->window.y - UI_TIMELINE_HEIGHT * 2)
+                {
+                    ui->seeking = true;
+                    seek_to_timeline(ui, view, event.button.x);
+                }
+                else
+                {
+                    ui->camera.dragging = true;
+                }
+                break;
+
+            case SDL_MOUSEBUTTONUP:
+                if (event.button.button == SDL_BUTTON_LEFT)
+                {
+                    ui->camera.dragging = false;
+                    ui->seeking = false;
+                }
+                break;
+
+            case SDL_MOUSEMOTION:
+                if (ui->seeking)
+                {
+                    seek_to_timeline(ui, view, event.motion.x);
+                }
+                else if (ui->camera.dragging)
+                {
+                    ui->camera.offset.x -= event.motion.xrel / ui->camera.zoom;
+                    ui->camera.offset.y -= event.motion.yrel / ui->camera.zoom;
+                }
+                break;
+
+            case SDL_RENDER_TARGETS_RESET:
+                ui->redraw = true;
+                break;
+
+            case SDL_RENDER_DEVICE_RESET:
+                // The canvas texture went with the device, so build a new one.
+                if (ui->canvas.texture) memory_count(MEMORY_TEXTURES, -(Sint64)ui->canvas.w * ui->canvas.h * 4);
+                ui->canvas.texture = NULL;
+                ui->redraw = true;
+                break;
+
+            case SDL_QUIT:
+                ui->quit = true;
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+#define OPTIONS_MAX_VARIANTS 16
+#define OPTIONS_MAX_BENCH 8
+
+typedef struct {
+    const char *export_path;
+    const char *svg_path;
+    const char *dump_path;
+    const char *load_path;
+    const char *genome_path;
+    const char *replay_path;
+    const char *stream_path;
+    const char *checkpoint_path;
+    int checkpoint_every;
+    const char *resume_path;
+    float spawn_chance;
+    int fork_at;
+    float variants[OPTIONS_MAX_VARIANTS];
+    int variant_count;
+    int frame_every;
+    const char *bench_path;
+    const char *render_bench_path;
+    const char *phase_log_path;
+    const char *trace_path;
+    const char *metrics_path;
+    const char *stats_path;
+    bool perf_counters;
+    const char *golden_path;
+    const char *update_golden_path;
+    bool differential;
+    Window bench_sizes[OPTIONS_MAX_BENCH];
+    int bench_size_count;
+    int bench_points[OPTIONS_MAX_BENCH];
+    int bench_point_count;
+    int bench_caps[OPTIONS_MAX_BENCH];
+    int bench_cap_count;
+    float tolerance;
+    float scale;
+    int thread_count;
+    bool verify;
+    Window size;
+    int initial_point_count;
+    unsigned int seed;
+} Options;
+
+void print_usage(void)
+{
+    printf("usage: hyphae [options]\n");
+    printf("  --export FILE.png    grow a diagram without a window and write it out\n");
+    printf("  --svg FILE.svg       grow a diagram without a window and write it out as one polyline per branch\n");
+    printf("  --dump FILE.hyd      grow a diagram without a window and write out its nodes\n");
+    printf("  --load FILE.hyd      export a dumped diagram instead of growing one (with --export)\n");
+    printf("  --genome FILE.hyg    grow a diagram without a window and write out the decisions that shaped it\n");
+    printf("  --replay FILE.hyg    regrow a diagram from its genome instead of the seed\n");
+    printf("  --stream FILE        grow a diagram without a window, sending each generation's nodes to FILE (- for stdout)\n");
+    printf("  --checkpoint FILE    grow a diagram without a window, saving where it's got to every so often (and on SIGUSR1)\n");
+    printf("  --checkpoint-every N generations between checkpoints (default 100, 0 for only on SIGUSR1)\n");
+    printf("  --resume FILE        carry on growing from a checkpoint instead of starting over\n");
+    printf("  --spawn-chance C     how likely new nodes are to spawn branches (default 1.5)\n");
+    printf("  --fork-at K          with --variants, grow to generation K once and fork the rest from there\n");
+    printf("  --variants A,B,...   finish the diagram once per spawn chance, numbering the outputs\n");
+    printf("  --frames K           with --export, also write the diagram as of every K-th generation, numbered by generation\n");
+    printf("  --bench FILE         time growth over every size, point count and node cap below, writing CSV (or JSON for .json)\n");
+    printf("  --bench-render FILE  time drawing diagrams of each bench size and node count (the caps) with the software renderer\n");
+    printf("  --bench-sizes W1xH1,...   sizes to bench (default 1440x980,2880x1960,5760x3920)\n");
+    printf("  --bench-points N1,...     initial point counts to bench (default 3,12)\n");
+    printf("  --bench-caps N1,...       node caps to bench (default 10000,100000,1000000)\n");
+#ifdef PHASE_TIMING
+    printf("  --perf-counters      count cycles, instructions, cache and branch misses per phase of growth and export (Linux)\n");
+    printf("  --phase-log FILE.csv write how long each phase took, per generation (headless) or per frame\n");
+#endif
+    printf("  --stats FILE.csv     grow a diagram without a window and write what the collision pass did each generation\n");
+    printf("  --trace FILE.json    write a Chrome trace of every generation, frame and export band\n");
+#ifndef _WIN32
+    printf("  --metrics SOCKET     answer each connection to the Unix socket SOCKET with the run's progress as JSON\n");
+#endif
+    printf("  --golden FILE        grow each case in FILE and check its nodes and image still hash to the digests there\n");
+    printf("                       (exits 1 if any changed, 2 if the images weren't compared because another toolchain wrote FILE)\n");
+    printf("  --update-golden FILE grow the standard cases and write their digests to FILE\n");
+    printf("  --differential       grow a diagram without a window, checking the grid's collision answers against the full scan\n");
+    printf("  --simplify T         drop polyline points that stray less than T from the line (default 0, off)\n");
+    printf("  --scale S            export at S times the simulation size (default 1)\n");
+    printf("  --threads N          threads to encode the export with (default: one per core)\n");
+    printf("  --verify             load the export back with SDL_image to check it\n");
+    printf("  --size WxH           simulation size for headless runs (default 1440x980)\n");
+    printf("  --points N           initial points (default 3)\n");
+    printf("  --seed N             random seed (default: the time)\n");
+}
+
+// Read a comma separated list of at most max positive numbers. Returns how many, or 0 if it isn't one.
+int parse_counts(char *list, int *counts, int max)
+{
+    int count = 0;
+    while (*list)
+    {
+        if (count == max) return 0;
+
+        char *end;
+        long value = strtol(list, &end, 10);
+        if (end == list || value < 1 || (*end != ',' && *end != '\0')) return 0;
+
+        counts[count] = (int)value;
+        count += 1;
+        list = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+// Same for WxH sizes.
+int parse_sizes(char *list, Window *sizes, int max)
+{
+    int count = 0;
+    while (*list)
+    {
+        if (count == max) return 0;
+
+        int length = 0;
+        if (sscanf(list, "%dx%d%n", &sizes[count].x, &sizes[count].y, &length) != 2 || length == 0) return 0;
+        if (sizes[count].x < 1 || sizes[count].y < 1) return 0;
+
+        list += length;
+        if (*list != ',' && *list != '\0') return 0;
+
+        count += 1;
+        if (*list == ',') list += 1;
+    }
+    return count;
+}
+
+bool parse_options(int argc, char *argv[], Options *options)
+{
+    options->export_path = NULL;
+    options->svg_path = NULL;
+    options->dump_path = NULL;
+    options->load_path = NULL;
+    options->genome_path = NULL;
+    options->replay_path = NULL;
+    options->stream_path = NULL;
+    options->checkpoint_path = NULL;
+    options->checkpoint_every = 100;
+    options->resume_path = NULL;
+    options->spawn_chance = 1.5;
+    options->fork_at = 0;
+    options->variant_count = 0;
+    options->frame_every = 0;
+    options->bench_path = NULL;
+    options->render_bench_path = NULL;
+    options->phase_log_path = NULL;
+    options->trace_path = NULL;
+    options->metrics_path = NULL;
+    options->stats_path = NULL;
+    options->perf_counters = false;
+    options->golden_path = NULL;
+    options->update_golden_path = NULL;
+    options->differential = false;
+    options->bench_size_count = parse_sizes((char[]){"1440x980,2880x1960,5760x3920"}, options->bench_sizes, OPTIONS_MAX_BENCH);
+    options->bench_point_count = parse_counts((char[]){"3,12"}, options->bench_points, OPTIONS_MAX_BENCH);
+    options->bench_cap_count = parse_counts((char[]){"10000,100000,1000000"}, options->bench_caps, OPTIONS_MAX_BENCH);
+    options->tolerance = 0;
+    options->scale = 1;
+    options->thread_count = SDL_GetCPUCount();
+    options->verify = false;
+    options->size = (Window){1440, 980};
+    options->initial_point_count = 3;
+    options->seed = (unsigned int)time(NULL);
+    bool seed_given = false;
+
+    for (int i = 1; i < argc; i += 1)
+    {
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(argv[i], "--export") == 0 && has_value)
+        {
+            options->export_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--svg") == 0 && has_value)
+        {
+            options->svg_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--dump") == 0 && has_value)
+        {
+            options->dump_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--load") == 0 && has_value)
+        {
+            options->load_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--genome") == 0 && has_value)
+        {
+            options->genome_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && has_value)
+        {
+            options->replay_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--stream") == 0 && has_value)
+        {
+            options->stream_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0 && has_value)
+        {
+            options->checkpoint_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && has_value)
+        {
+            options->checkpoint_every = atoi(argv[++i]);
+            if (options->checkpoint_every < 0) return false;
+        }
+        else if (strcmp(argv[i], "--resume") == 0 && has_value)
+        {
+            options->resume_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--spawn-chance") == 0 && has_value)
+        {
+            options->spawn_chance = (float)atof(argv[++i]);
+            if (options->spawn_chance < 0) return false;
+        }
+        else if (strcmp(argv[i], "--fork-at") == 0 && has_value)
+        {
+            options->fork_at = atoi(argv[++i]);
+            if (options->fork_at < 0) return false;
+        }
+        else if (strcmp(argv[i], "--variants") == 0 && has_value)
+        {
+            char *list = argv[++i];
+            options->variant_count = 0;
+            while (*list)
+            {
+                if (options->variant_count == OPTIONS_MAX_VARIANTS) return false;
+
+                char *end;
+                options->variants[options->variant_count] = (float)strtod(list, &end);
+                if (end == list || options->variants[options->variant_count] < 0) return false;
+                options->variant_count += 1;
+
+                list = *end == ',' ? end + 1 : end;
+                if (*end != ',' && *end != '\0') return false;
+            }
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && has_value)
+        {
+            options->frame_every = atoi(argv[++i]);
+            if (options->frame_every < 1) return false;
+        }
+        else if (strcmp(argv[i], "--bench") == 0 && has_value)
+        {
+            options->bench_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench-render") == 0 && has_value)
+        {
+            options->render_bench_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench-sizes") == 0 && has_value)
+        {
+            options->bench_size_count = parse_sizes(argv[++i], options->bench_sizes, OPTIONS_MAX_BENCH);
+            if (options->bench_size_count == 0) return false;
+        }
+        else if (strcmp(argv[i], "--bench-points") == 0 && has_value)
+        {
+            options->bench_point_count = parse_counts(argv[++i], options->bench_points, OPTIONS_MAX_BENCH);
+            if (options->bench_point_count == 0) return false;
+        }
+        else if (strcmp(argv[i], "--bench-caps") == 0 && has_value)
+        {
+            options->bench_cap_count = parse_counts(argv[++i], options->bench_caps, OPTIONS_MAX_BENCH);
+            if (options->bench_cap_count == 0) return false;
+        }
+#ifdef PHASE_TIMING
+        else if (strcmp(argv[i], "--perf-counters") == 0)
+        {
+            options->perf_counters = true;
+        }
+        else if (strcmp(argv[i], "--phase-log") == 0 && has_value)
+        {
+            options->phase_log_path = argv[++i];
+        }
+#endif
+        else if (strcmp(argv[i], "--stats") == 0 && has_value)
+        {
+            options->stats_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && has_value)
+        {
+            options->trace_path = argv[++i];
+        }
+#ifndef _WIN32
+        else if (strcmp(argv[i], "--metrics") == 0 && has_value)
+        {
+            options->metrics_path = argv[++i];
+        }
+#endif
+        else if (strcmp(argv[i], "--golden") == 0 && has_value)
+        {
+            options->golden_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--update-golden") == 0 && has_value)
+        {
+            options->update_golden_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--differential") == 0)
+        {
+            options->differential = true;
+        }
+        else if (strcmp(argv[i], "--simplify") == 0 && has_value)
+        {
+            options->tolerance = (float)atof(argv[++i]);
+            if (options->tolerance < 0) return false;
+        }
+        else if (strcmp(argv[i], "--scale") == 0 && has_value)
+        {
+            options->scale = (float)atof(argv[++i]);
+            if (options->scale <= 0) return false;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && has_value)
+        {
+            options->thread_count = atoi(argv[++i]);
+            if (options->thread_count < 1) return false;
+        }
+        else if (strcmp(argv[i], "--verify") == 0)
+        {
+            options->verify = true;
+        }
+        else if (strcmp(argv[i], "--size") == 0 && has_value)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options->size.x, &options->size.y) != 2) return false;
+            if (options->size.x < 1 || options->size.y < 1) return false;
+        }
+        else if (strcmp(argv[i], "--points") == 0 && has_value)
+        {
+            options->initial_point_count = atoi(argv[++i]);
+            if (options->initial_point_count < 0) return false;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && has_value)
+        {
+            options->seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+            seed_given = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // A dump only holds what the PNG export needs.
+    if (options->load_path && (!options->export_path || options->svg_path || options->dump_path || options->genome_path || options->replay_path ||
+        options->stream_path || options->checkpoint_path || options->resume_path || options->stats_path || options->perf_counters)) return false;
+
+    // Genomes hold every decision from the start of a run.
+    if (options->resume_path && (options->genome_path || options->replay_path)) return false;
+
+    // Benches only time growth or drawing, and always from the same seed unless told otherwise.
+    bool benching = options->bench_path || options->render_bench_path;
+    if (benching && (options->stats_path || options->perf_counters || options->export_path || options->svg_path || options->dump_path || options->load_path || options->genome_path ||
+        options->replay_path || options->stream_path || options->checkpoint_path || options->resume_path || options->variant_count > 0)) return false;
+    if (benching && !seed_given) options->seed = 1;
+
+    // Golden cases set their own sizes, seeds and caps, and write nothing but digests.
+    bool golden = options->golden_path || options->update_golden_path;
+    if (golden && (benching || options->stats_path || options->perf_counters || options->export_path || options->svg_path || options->dump_path ||
+        options->load_path || options->genome_path || options->replay_path || options->stream_path || options->checkpoint_path || options->resume_path ||
+        options->variant_count > 0 || options->trace_path || options->phase_log_path || seed_given)) return false;
+    if (options->golden_path && options->update_golden_path) return false;
+
+    // A replay or a dump has no collision tests to compare.
+    if (options->differential && (benching || options->load_path || options->replay_path || options->variant_count > 0)) return false;
+
+    // Traces and metrics follow one run as it grows.
+    if (options->trace_path && (benching || options->load_path || options->variant_count > 0)) return false;
+    if (options->metrics_path && (benching || golden || options->load_path || options->variant_count > 0)) return false;
+
+    // Frames are PNGs of a graph grown here.
+    if (options->frame_every > 0 && (!options->export_path || options->load_path)) return false;
+
+    // Variants only write out their finished diagrams.
+    if (options->variant_count > 0 && (options->frame_every > 0 || options->stats_path || options->perf_counters || options->load_path || options->genome_path || options->replay_path || options->stream_path || options->checkpoint_path)) return false;
+
+    return true;
+}
+
+bool write_png_export(Export_Source *source, Options *options)
+{
+    if (!export_png(source, options->export_path, options->scale, options->thread_count))
+    {
+        printf("Export error: couldn't write %s\n", options->export_path);
+        return false;
+    }
+
+    int width = (int)(source->window.x * options->scale + 0.5);
+    int height = (int)(source->window.y * options->scale + 0.5);
+    printf("wrote %s (%dx%d)\n", options->export_path, width, height);
+
+    if (options->verify)
+    {
+        // Read it back with SDL_image to make sure other decoders will take it.
+        SDL_Surface *surface = IMG_Load(options->export_path);
+        if (!surface || surface->w != width || surface->h != height)
+        {
+            printf("Export error: %s didn't load back (%s)\n", options->export_path, IMG_GetError());
+            return false;
+        }
+
+        SDL_FreeSurface(surface);
+        printf("verified %s\n", options->export_path);
+    }
+
+    return true;
+}
+
+bool write_svg_export(Graph *graph, Options *options)
+{
+    if (!export_svg(graph, options->svg_path, options->tolerance))
+    {
+        printf("Export error: couldn't write %s\n", options->svg_path);
+        return false;
+    }
+
+    printf("wrote %s\n", options->svg_path);
+    return true;
+}
+
+bool write_dump(Graph *graph, Options *options)
+{
+    if (!dump_write(graph, options->dump_path))
+    {
+        printf("Export error: couldn't write %s\n", options->dump_path);
+        return false;
+    }
+
+    printf("wrote %s\n", options->dump_path);
+    return true;
+}
+
+bool is_headless(Options *options)
+{
+    return options->export_path || options->svg_path || options->dump_path || options->genome_path || options->replay_path ||
+        options->stream_path || options->checkpoint_path || options->resume_path || options->variant_count > 0 ||
+        options->bench_path || options->render_bench_path || options->stats_path || options->perf_counters ||
+        options->golden_path || options->update_golden_path || options->differential;
+}
+
+// Export a dump straight from its mapped columns, without growing or loading a graph.
+int run_load(Options *options)
+{
+    Node_Dump dump;
+    if (!dump_open(&dump, options->load_path) || !dump_index_rows(&dump))
+    {
+        printf("Load error: %s isn't a node dump this version can read\n", options->load_path);
+        dump_close(&dump);
+        return 1;
+    }
+
+    printf("mapped %u nodes (seed %u)\n", dump.header->node_count, dump.header->seed);
+
+    Export_Source source = {0};
+    source.dump = &dump;
+    source.window = (Window){dump.header->window_x, dump.header->window_y};
+
+    bool ok = write_png_export(&source, options);
+    dump_close(&dump);
+
+    return ok ? 0 : 1;
+}
+
+// path with "-number" put in front of its extension, in buffer.
+const char *variant_path(const char *path, int number, char *buffer, int size)
+{
+    const char *extension = strrchr(path, '.');
+    const char *separator = strrchr(path, '/');
+    if (!extension || (separator && separator > extension)) extension = path + strlen(path);
+
+    snprintf(buffer, size, "%.*s-%d%s", (int)(extension - path), path, number, extension);
+    return buffer;
+}
+
+// Write out graph as of every frame_every-th generation, numbered by generation. Each one's a
+// prefix of the nodes, so they all come from the one finished graph.
+bool write_frames(Graph *graph, Options *options)
+{
+    for (int generation = options->frame_every; generation < graph->generation; generation += options->frame_every)
+    {
+        Graph frame = *graph;
+        frame.node_count = graph_generation_end(graph, generation);
+
+        char export_path[1024];
+        Options frame_options = *options;
+        frame_options.export_path = variant_path(options->export_path, generation, export_path, sizeof(export_path));
+
+        Export_Source source = {0};
+        source.graph = &frame;
+        source.window = frame.window;
+        source.trace = graph->trace;
+
+        if (!write_png_export(&source, &frame_options)) return false;
+    }
+
+    return true;
+}
+
+// Grow graph to the fork generation, then fork it once per variant spawn chance and
+// grow each fork the rest of the way on its own, writing each out with its number.
+int run_variants(Options *options, Graph *graph)
+{
+    while (graph->generation < options->fork_at && (graph->do_iteration || graph->active_point_count > 0))
+    {
+        update(graph);
+    }
+    printf("grew %d nodes to generation %d (seed %u)\n", graph->node_count, graph->generation, graph->seed);
+
+    for (int v = 0; v < options->variant_count; v += 1)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        Graph fork;
+        graph_fork(&fork, graph);
+        double fork_microseconds = (double)(SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+
+        fork.spawn_chance = options->variants[v];
+        grow_headless(&fork, NULL, NULL, NULL, NULL, NULL);
+
+        int shared = 0;
+        int owned = 0;
+        paged_count(&fork.nodes, &shared, &owned);
+        printf("variant %d (spawn chance %g): forked in %.1f us, grew to %d nodes, %d node pages shared and %d its own\n",
+            v + 1, fork.spawn_chance, fork_microseconds, fork.node_count, shared, owned);
+
+        char export_path[1024], svg_path[1024], dump_path[1024];
+        Options variant = *options;
+        if (options->export_path) variant.export_path = variant_path(options->export_path, v + 1, export_path, sizeof(export_path));
+        if (options->svg_path) variant.svg_path = variant_path(options->svg_path, v + 1, svg_path, sizeof(svg_path));
+        if (options->dump_path) variant.dump_path = variant_path(options->dump_path, v + 1, dump_path, sizeof(dump_path));
+
+        Export_Source source = {0};
+        source.graph = &fork;
+        source.window = fork.window;
+
+        bool ok = (!variant.export_path || write_png_export(&source, &variant)) &&
+            (!variant.svg_path || write_svg_export(&fork, &variant)) &&
+            (!variant.dump_path || write_dump(&fork, &variant));
+
+        graph_free(&fork);
+        if (!ok) return 1;
+    }
+
+    print_memory();
+    graph_free(graph);
+    return 0;
+}
+
+bool is_json_path(const char *path)
+{
+    const char *extension = strrchr(path, '.');
+    return extension && strcmp(extension, ".json") == 0;
+}
+
+typedef struct {
+    Window size;
+    int initial_point_count;
+    int max_nodes;
+    unsigned int seed;
+
+    int node_count;
+    int generation_count;
+    double seconds;
+    double longest_generation;
+    double p50_generation_ms;
+    double p99_generation_ms;
+
+    // The most the memory tracker saw held at once during the run, over what was held before it.
+    size_t peak_bytes;
+} Bench_Result;
+
+Bench_Result bench_growth(Window size, int initial_point_count, int max_nodes, unsigned int seed)
+{
+    Bench_Result result = {.size = size, .initial_point_count = initial_point_count, .max_nodes = max_nodes, .seed = seed};
+
+    Histogram generation_times;
+    histogram_reset(&generation_times);
+
+    memory_reset_peaks();
+    Sint64 held_before = memory_snapshot().total;
+
+    Graph graph;
+    graph_init(&graph, max_nodes);
+    graph.initial_point_count = initial_point_count;
+    graph.window = size;
+    graph.do_iteration = true;
+    graph_seed(&graph, seed);
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    do
+    {
+        int generation = graph.generation;
+        Uint64 start = SDL_GetPerformanceCounter();
+        update(&graph);
+        Uint64 ticks = SDL_GetPerformanceCounter() - start;
+        double seconds = (double)ticks / frequency;
+
+        // The call that finds the cap already reached commits no generation.
+        if (graph.generation > generation) histogram_record_ticks(&generation_times, ticks);
+
+        result.seconds += seconds;
+        if (seconds > result.longest_generation) result.longest_generation = seconds;
+    } while (graph.active_point_count > 0);
+
+    result.node_count = graph.node_count;
+    result.generation_count = graph.generation;
+    result.p50_generation_ms = histogram_percentile(&generation_times, 50);
+    result.p99_generation_ms = histogram_percentile(&generation_times, 99);
+
+    graph_free(&graph);
+    result.peak_bytes = memory_snapshot().total_peak - held_before;
+
+    return result;
+}
+
+void write_bench_result(FILE *file, bool json, bool first, Bench_Result *result)
+{
+    double mean_generation = result->generation_count > 0 ? result->seconds / result->generation_count : 0;
+    double nodes_per_second = result->seconds > 0 ? result->node_count / result->seconds : 0;
+
+    if (json)
+    {
+        fprintf(file, "%s\n  {\"width\": %d, \"height\": %d, \"points\": %d, \"max_nodes\": %d, \"seed\": %u, "
+            "\"nodes\": %d, \"generations\": %d, \"seconds\": %.6f, \"mean_generation_ms\": %.4f, "
+            "\"p50_generation_ms\": %.4f, \"p99_generation_ms\": %.4f, \"longest_generation_ms\": %.4f, "
+            "\"nodes_per_second\": %.0f, \"peak_bytes\": %llu}",
+            first ? "" : ",", result->size.x, result->size.y, result->initial_point_count, result->max_nodes, result->seed,
+            result->node_count, result->generation_count, result->seconds, mean_generation * 1000,
+            result->p50_generation_ms, result->p99_generation_ms, result->longest_generation * 1000, nodes_per_second,
+            (unsigned long long)result->peak_bytes);
+    }
+    else
+    {
+        fprintf(file, "%d,%d,%d,%d,%u,%d,%d,%.6f,%.4f,%.4f,%.4f,%.4f,%.0f,%llu\n",
+            result->size.x, result->size.y, result->initial_point_count, result->max_nodes, result->seed,
+            result->node_count, result->generation_count, result->seconds, mean_generation * 1000,
+            result->p50_generation_ms, result->p99_generation_ms, result->longest_generation * 1000, nodes_per_second,
+            (unsigned long long)result->peak_bytes);
+    }
+
+    // Whatever's done so far survives a long matrix being cut short.
+    fflush(file);
+}
+
+// Grow one diagram for every combination of bench size, initial point count and node cap, all from the same seed.
+int run_bench(Options *options)
+{
+    FILE *file = fopen(options->bench_path, "wb");
+    if (!file)
+    {
+        printf("Export error: couldn't write %s\n", options->bench_path);
+        return 1;
+    }
+
+    bool json = is_json_path(options->bench_path);
+
+    if (json) fprintf(file, "[");
+    else fprintf(file, "width,height,points,max_nodes,seed,nodes,generations,seconds,mean_generation_ms,p50_generation_ms,p99_generation_ms,longest_generation_ms,nodes_per_second,peak_bytes\n");
+
+    bool first = true;
+    for (int s = 0; s < options->bench_size_count; s += 1)
+    {
+        for (int p = 0; p < options->bench_point_count; p += 1)
+        {
+            for (int c = 0; c < options->bench_cap_count; c += 1)
+            {
+#ifndef NODES_ON_HEAP
+                // Without NODES_ON_HEAP a generation's new nodes go on the stack, which only has room for MAX_NODES.
+                if (options->bench_caps[c] > MAX_NODES)
+                {
+                    printf("skipped cap %d (more than %d)\n", options->bench_caps[c], MAX_NODES);
+                    continue;
+                }
+#endif
+
+                Bench_Result result = bench_growth(options->bench_sizes[s], options->bench_points[p], options->bench_caps[c], options->seed);
+
+                printf("%dx%d, %d points, cap %d: %d nodes in %d generations, %.3f s (%.0f nodes/s, generations p50 %.2f ms, "
+                    "p99 %.2f ms, longest %.2f ms, peak %.1f MB)\n",
+                    result.size.x, result.size.y, result.initial_point_count, result.max_nodes, result.node_count, result.generation_count,
+                    result.seconds, result.seconds > 0 ? result.node_count / result.seconds : 0, result.p50_generation_ms,
+                    result.p99_generation_ms, result.longest_generation * 1000, memory_megabytes(result.peak_bytes));
+
+                write_bench_result(file, json, first, &result);
+                first = false;
+            }
+        }
+    }
+
+    if (json) fprintf(file, "\n]\n");
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    if (!ok)
+    {
+        printf("Export error: couldn't write %s\n", options->bench_path);
+        return 1;
+    }
+
+    printf("wrote %s\n", options->bench_path);
+    return 0;
+}
+
+// Each case is run until it's taken at least this long, and at least this many times.
+#define RENDER_BENCH_SECONDS 0.5
+#define RENDER_BENCH_REPEATS 3
+
+typedef enum {
+    RENDER_BENCH_RENDER_REDRAW,
+    RENDER_BENCH_RENDER,
+    RENDER_BENCH_RENDER_ZOOMED,
+    RENDER_BENCH_RENDER_SEEK_BACK,
+    RENDER_BENCH_DRAW_CIRCLE,
+    RENDER_BENCH_DRAW_TEXT,
+    RENDER_BENCH_RASTER,
+    RENDER_BENCH_CASE_COUNT
+} Render_Bench_Case;
+
+const char *render_bench_names[RENDER_BENCH_CASE_COUNT] = {
+    "render_redraw", "render", "render_zoomed", "render_seek_back", "draw_circle", "draw_text", "raster_band",
+};
+
+// Run one case once. Returns how many things it drew.
+int render_bench_once(Render_Bench_Case which, SDL_Renderer *renderer, Graph *graph, UI *ui, Uint8 *band, int **indices, int *capacity)
+{
+    switch (which)
+    {
+        case RENDER_BENCH_RENDER_REDRAW:
+            // A whole frame, rebuilding the canvas first as if the run had just been restarted.
+            ui->redraw = true;
+            render(renderer, *graph, ui);
+            return graph->node_count;
+
+        case RENDER_BENCH_RENDER:
+            // A whole frame with nothing new, which is most of them once a run's finished.
+            render(renderer, *graph, ui);
+            return 1;
+
+        case RENDER_BENCH_RENDER_ZOOMED:
+        {
+            // Zoomed in on the middle, which draws the visible nodes straight to the window.
+            Camera camera = ui->camera;
+            ui->camera.zoom_level = 4;
+            ui->camera.zoom = pow(CAMERA_ZOOM_STEP, ui->camera.zoom_level);
+            ui->camera.offset = (vec2){graph->window.x / 2 - graph->window.x / 2 / ui->camera.zoom, graph->window.y / 2 - graph->window.y / 2 / ui->camera.zoom};
+            render(renderer, *graph, ui);
+            ui->camera = camera;
+            return 1;
+        }
+
+        case RENDER_BENCH_RENDER_SEEK_BACK:
+        {
+            // A frame just after seeking back a generation from the end, the slowest seek there is: the canvas
+            // is cleared and all but the last generation drawn again. It's told the whole diagram is on it now.
+            int generation = graph->generation - 1;
+            while (generation > 1 && graph_generation_end(graph, generation) >= graph->node_count) generation -= 1;
+
+            ui->canvas.drawn_count = graph->node_count;
+            ui->seek_generation = generation;
+            render(renderer, *graph, ui);
+            ui->seek_generation = 0;
+            return graph_generation_end(graph, generation);
+        }
+
+        case RENDER_BENCH_DRAW_CIRCLE:
+            SDL_SetRenderTarget(renderer, ui->canvas.texture);
+            for (int i = 0; i < graph->node_count; i += 1)
+            {
+                Node *node = graph_node(graph, i);
+                draw_circle(renderer, node->circle, node->color);
+            }
+            SDL_SetRenderTarget(renderer, NULL);
+            return graph->node_count;
+
+        case RENDER_BENCH_DRAW_TEXT:
+            for (int i = 0; i < UI_LINE_COUNT; i += 1)
+            {
+                draw_text(renderer, &ui->atlas, &ui->lines[i], ui->font_color);
+            }
+            return UI_LINE_COUNT;
+
+        case RENDER_BENCH_RASTER:
+        {
+            // The export's own rasterizer, over the whole diagram at 1:1.
+            Export_Source source = {0};
+            source.graph = graph;
+            source.window = graph->window;
+            raster_band(&source, 1, band, graph->window.x, 0, graph->window.y, indices, capacity);
+            return graph->node_count;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+// Grow a diagram per bench size, then time drawing the first node_count nodes of it for every
+// bench cap, through SDL's software renderer (on the dummy video driver unless another's asked for)
+// and through the export's rasterizer. Needs no display.
+int run_render_bench(Options *options)
+{
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+    {
+        printf("SDL_Init video error: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    Window largest = {1, 1};
+    for (int s = 0; s < options->bench_size_count; s += 1)
+    {
+        if (options->bench_sizes[s].x > largest.x) largest.x = options->bench_sizes[s].x;
+        if (options->bench_sizes[s].y > largest.y) largest.y = options->bench_sizes[s].y;
+    }
+
+    int max_nodes = 1;
+    for (int c = 0; c < options->bench_cap_count; c += 1)
+    {
+        if (options->bench_caps[c] > max_nodes) max_nodes = options->bench_caps[c];
+    }
+#ifndef NODES_ON_HEAP
+    if (max_nodes > MAX_NODES) max_nodes = MAX_NODES;
+#endif
+
+    SDL_Window *win = SDL_CreateWindow("Hyphae", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, largest.x, largest.y, SDL_WINDOW_HIDDEN);
+    SDL_Renderer *ren = win ? SDL_CreateRenderer(win, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE) : NULL;
+    if (!ren)
+    {
+        printf("SDL_CreateRenderer error: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    UI ui = {0};
+    ui.font_color = (SDL_Color){255, 255, 255, 255};
+    ui.render_intermediate = true;
+    ui.camera.zoom = 1;
+
+    // The overlay's only drawn if there's a font to draw it with.
+    TTF_Init();
+    ui.font = TTF_OpenFont("liberation.ttf", 12);
+    ui.show = ui.font && build_glyph_atlas(ren, ui.font, &ui.atlas);
+    if (!ui.show) printf("no liberation.ttf, so skipping text\n");
+
+    FILE *file = fopen(options->render_bench_path, "wb");
+    if (!file)
+    {
+        printf("Export error: couldn't write %s\n", options->render_bench_path);
+        return 1;
+    }
+
+    bool json = is_json_path(options->render_bench_path);
+    if (json) fprintf(file, "[");
+    else fprintf(file, "width,height,nodes,case,repeats,ms_per_frame,draws_per_second\n");
+
+    bool first = true;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    for (int s = 0; s < options->bench_size_count; s += 1)
+    {
+        Graph graph;
+        graph_init(&graph, max_nodes);
+        graph.initial_point_count = options->bench_points[0];
+        graph.window = options->bench_sizes[s];
+        graph.do_iteration = true;
+        graph_seed(&graph, options->seed);
+        grow_headless(&graph, NULL, NULL, NULL, NULL, NULL);
+
+        size_t band_size = (size_t)graph.window.x * graph.window.y * 3;
+        Uint8 *band = memory_alloc(MEMORY_FRAMEBUFFERS, band_size);
+        int *indices = NULL;
+        int capacity = 0;
+
+        int measured_count = -1;
+        for (int c = 0; c < options->bench_cap_count; c += 1)
+        {
+            // Caps past what the diagram grew to would all measure the same thing.
+            Graph shown = graph;
+            if (options->bench_caps[c] < shown.node_count) shown.node_count = options->bench_caps[c];
+            if (shown.node_count == measured_count) continue;
+            measured_count = shown.node_count;
+
+            for (int which = 0; which < RENDER_BENCH_CASE_COUNT; which += 1)
+            {
+                if (which == RENDER_BENCH_DRAW_TEXT && !ui.show) continue;
+
+                int repeats = 0;
+                Uint64 draws = 0;
+                Uint64 start = SDL_GetPerformanceCounter();
+                double seconds = 0;
+                while (repeats < RENDER_BENCH_REPEATS || seconds < RENDER_BENCH_SECONDS)
+                {
+                    draws += render_bench_once(which, ren, &shown, &ui, band, &indices, &capacity);
+                    repeats += 1;
+                    seconds = (double)(SDL_GetPerformanceCounter() - start) / frequency;
+                }
+
+                double frame_ms = seconds * 1000 / repeats;
+                double draws_per_second = seconds > 0 ? draws / seconds : 0;
+                printf("%dx%d, %d nodes, %s: %.3f ms per frame (%.0f draws/s)\n",
+                    shown.window.x, shown.window.y, shown.node_count, render_bench_names[which], frame_ms, draws_per_second);
+
+                if (json)
+                {
+                    fprintf(file, "%s\n  {\"width\": %d, \"height\": %d, \"nodes\": %d, \"case\": \"%s\", \"repeats\": %d, "
+                        "\"ms_per_frame\": %.4f, \"draws_per_second\": %.0f}",
+                        first ? "" : ",", shown.window.x, shown.window.y, shown.node_count, render_bench_names[which], repeats,
+                        frame_ms, draws_per_second);
+                }
+                else
+                {
+                    fprintf(file, "%d,%d,%d,%s,%d,%.4f,%.0f\n",
+                        shown.window.x, shown.window.y, shown.node_count, render_bench_names[which], repeats, frame_ms, draws_per_second);
+                }
+                fflush(file);
+                first = false;
+            }
+        }
+
+        memory_free(MEMORY_FRAMEBUFFERS, band, band_size);
+        memory_free(MEMORY_SCRATCH, indices, sizeof(int) * capacity);
+        graph_free(&graph);
+    }
+
+    if (json) fprintf(file, "\n]\n");
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+
+    SDL_DestroyRenderer(ren);
+    SDL_DestroyWindow(win);
+    SDL_Quit();
+
+    if (!ok)
+    {
+        printf("Export error: couldn't write %s\n", options->render_bench_path);
+        return 1;
+    }
+
+    printf("wrote %s\n", options->render_bench_path);
+    return 0;
+}
+
+void print_divergence(Divergence *divergence)
+{
+    if (divergence->diverged)
+    {
+        printf("the grid and the full scan first disagree in generation %d, on node %d (from node %d, at %.3f, %.3f): the full scan says it %s\n",
+            divergence->generation, divergence->node_index, divergence->parent, divergence->center.x, divergence->center.y,
+            divergence->full_scan_collided ? "collides" : "fits");
+    }
+    else
+    {
+        printf("the grid and the full scan agree on all %llu continuations\n", (unsigned long long)divergence->checked_count);
+    }
+}
+
+// Grow a golden case from its seed and fill in what it came to.
+void golden_grow(Golden_Case *golden, Divergence *differential)
+{
+    Graph graph;
+    graph_init(&graph, golden->max_nodes);
+    graph.initial_point_count = golden->initial_point_count;
+    graph.window = golden->size;
+    graph.do_iteration = true;
+    graph_seed(&graph, golden->seed);
+    graph.differential = differential;
+
+    grow_headless(&graph, NULL, NULL, NULL, NULL, NULL);
+
+    golden->node_count = graph.node_count;
+    golden->generation_count = graph.generation;
+    golden->node_digest = golden_node_digest(&graph);
+    golden->image_digest = golden_image_digest(&graph);
+
+    graph_free(&graph);
+}
+
+// Grow every case in the golden file and check it still comes out the same, or grow
+// the standard cases and write a new golden file.
+int run_golden(Options *options)
+{
+    Golden_Case cases[GOLDEN_MAX_CASES];
+    char toolchain[GOLDEN_TOOLCHAIN_MAX];
+    bool same_toolchain = true;
+    int count;
+    if (options->update_golden_path)
+    {
+        count = sizeof(golden_default_cases) / sizeof(Golden_Case);
+        memcpy(cases, golden_default_cases, sizeof(golden_default_cases));
+    }
+    else
+    {
+        count = golden_read(options->golden_path, cases, GOLDEN_MAX_CASES, toolchain);
+        if (count < 1)
+        {
+            printf("Load error: %s isn't a golden file\n", options->golden_path);
+            return 1;
+        }
+
+        // Another toolchain's float math puts nodes in slightly different places, which isn't a regression.
+        if (strcmp(toolchain, GOLDEN_TOOLCHAIN) != 0)
+        {
+            printf("warning: %s was written by %s and this build is %s, so only node counts and structure are compared, "
+                "not images; regenerate it with --update-golden to check this build against itself\n",
+                options->golden_path, toolchain[0] ? toolchain : "an unknown toolchain", GOLDEN_TOOLCHAIN);
+            same_toolchain = false;
+        }
+    }
+
+    int failed_count = 0;
+    for (int i = 0; i < count; i += 1)
+    {
+        Golden_Case expected = cases[i];
+        Golden_Case *golden = &cases[i];
+
+        Divergence divergence = {0};
+        Uint64 start = SDL_GetPerformanceCounter();
+        golden_grow(golden, options->differential ? &divergence : NULL);
+        double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+        bool matches = golden->node_count == expected.node_count && golden->generation_count == expected.generation_count &&
+            golden->node_digest == expected.node_digest && (!same_toolchain || golden->image_digest == expected.image_digest);
+
+        printf("%dx%d, %d points, cap %d, seed %u: %d nodes in %d generations (%.3f s)%s\n", golden->size.x, golden->size.y,
+            golden->initial_point_count, golden->max_nodes, golden->seed, golden->node_count, golden->generation_count, seconds,
+            options->update_golden_path ? "" : matches ? ", same" : ", CHANGED");
+
+        if (options->golden_path && !matches)
+        {
+            printf("  expected %d nodes in %d generations, nodes %016llx, image %016llx\n", expected.node_count, expected.generation_count,
+                (unsigned long long)expected.node_digest, (unsigned long long)expected.image_digest);
+            printf("  got      %d nodes in %d generations, nodes %016llx, image %016llx\n", golden->node_count, golden->generation_count,
+                (unsigned long long)golden->node_digest, (unsigned long long)golden->image_digest);
+        }
+
+        if (options->differential)
+        {
+            printf("  ");
+            print_divergence(&divergence);
+            memory_free(MEMORY_SCRATCH, divergence.indices, sizeof(int) * divergence.capacity);
+        }
+
+        if ((options->golden_path && !matches) || divergence.diverged) failed_count += 1;
+    }
+
+    if (options->update_golden_path)
+    {
+        FILE *file = fopen(options->update_golden_path, "wb");
+        if (!file)
+        {
+            printf("Export error: couldn't write %s\n", options->update_golden_path);
+            return 1;
+        }
+
+        fprintf(file, "# Golden digests for hyphae --golden; regenerate with --update-golden.\n");
+        fprintf(file, "# width height points max_nodes seed   nodes generations   node_digest image_digest\n");
+        fprintf(file, "toolchain %s\n", GOLDEN_TOOLCHAIN);
+        for (int i = 0; i < count; i += 1)
+        {
+            golden_write_case(file, &cases[i]);
+        }
+
+        bool ok = !ferror(file);
+        if (fclose(file) != 0 || !ok)
+        {
+            printf("Export error: couldn't write %s\n", options->update_golden_path);
+            return 1;
+        }
+
+        printf("wrote %s (%d cases)\n", options->update_golden_path, count);
+    }
+    else
+    {
+        printf("%d of %d cases came out the same%s\n", count - failed_count, count, same_toolchain ? "" : ", not counting their images");
+    }
+
+    // Images that weren't compared aren't a pass: 2 says so, unless something that was compared failed.
+    if (failed_count > 0) return 1;
+    return same_toolchain || options->update_golden_path ? 0 : 2;
+}
+
+int run_headless(Options *options)
+{
+    if (options->load_path) return run_load(options);
+    if (options->golden_path || options->update_golden_path) return run_golden(options);
+    if (options->bench_path || options->render_bench_path)
+    {
+        if (options->bench_path && run_bench(options) != 0) return 1;
+        return options->render_bench_path ? run_render_bench(options) : 0;
+    }
+
+    Graph graph;
+    graph_init(&graph, MAX_NODES);
+    graph.initial_point_count = options->initial_point_count;
+    graph.window = options->size;
+    graph.do_iteration = true;
+    graph.spawn_chance = options->spawn_chance;
+    graph_seed(&graph, options->seed);
+
+    // A resumed run picks up exactly where its checkpoint left off, spawn chance and all.
+    if (options->resume_path)
+    {
+        if (!checkpoint_load(&graph, options->resume_path, MAX_NODES))
+        {
+            printf("Load error: %s isn't a checkpoint this build can resume\n", options->resume_path);
+            return 1;
+        }
+
+        printf("resumed %d nodes at generation %d (seed %u)\n", graph.node_count, graph.generation, graph.seed);
+    }
+
+    if (options->variant_count > 0) return run_variants(options, &graph);
+
+    // A replayed run takes everything that shaped it from the genome.
+    Genome replayed = {0};
+    Uint64 replay_decision_count = 0;
+    if (options->replay_path)
+    {
+        if (!genome_load(&replayed, options->replay_path) || replayed.max_nodes > MAX_NODES)
+        {
+            printf("Load error: %s isn't a genome this version can replay\n", options->replay_path);
+            return 1;
+        }
+
+        graph.max_nodes = replayed.max_nodes;
+        graph.initial_point_count = replayed.initial_point_count;
+        graph.window = (Window){replayed.window_x, replayed.window_y};
+        graph.seed = replayed.seed;
+
+        replay_decision_count = replayed.decision_count;
+        genome_begin_replay(&replayed);
+        graph.replay = &replayed;
+    }
+
+    Genome recorded = {0};
+    if (options->genome_path)
+    {
+        recorded.window_x = graph.window.x;
+        recorded.window_y = graph.window.y;
+        recorded.initial_point_count = graph.initial_point_count;
+        recorded.max_nodes = graph.max_nodes;
+        recorded.seed = graph.seed;
+
+        genome_begin_record(&recorded);
+        graph.record = &recorded;
+    }
+
+    Node_Stream stream;
+    if (options->stream_path && !stream_open(&stream, options->stream_path, graph.window, graph.seed))
+    {
+        printf("Export error: couldn't open %s\n", options->stream_path);
+        return 1;
+    }
+
+    // Readers need the nodes a resumed run starts with before the ones that grow from them.
+    if (options->stream_path && graph.node_count > 0 && !graph.do_iteration && !stream_generation(&stream, &graph, 0, graph.node_count))
+    {
+        printf("Export error: couldn't write to %s\n", options->stream_path);
+        return 1;
+    }
+
+    Checkpointer checkpointer;
+    if (options->checkpoint_path)
+    {
+        checkpoint_start(&checkpointer, options->checkpoint_path, options->checkpoint_every);
+#ifdef SIGUSR1
+        signal(SIGUSR1, request_checkpoint);
+#endif
+    }
+
+    Phase_Log log;
+    if (options->phase_log_path && !phase_log_open(&log, options->phase_log_path))
+    {
+        printf("Export error: couldn't write %s\n", options->phase_log_path);
+        return 1;
+    }
+
+    Trace trace;
+    if (options->trace_path)
+    {
+        if (!trace_start(&trace, options->trace_path))
+        {
+            printf("Export error: couldn't write %s\n", options->trace_path);
+            return 1;
+        }
+
+        trace_name_thread(&trace, "main");
+        graph.trace = &trace;
+    }
+
+    Metrics metrics;
+    if (options->metrics_path)
+    {
+        if (!metrics_start(&metrics, options->metrics_path))
+        {
+            printf("Metrics error: couldn't listen on %s\n", options->metrics_path);
+            return 1;
+        }
+
+        graph.metrics = &metrics;
+    }
+
+    Perf_Counters update_perf;
+    Perf_Counters export_perf;
+    memset(&export_perf, 0, sizeof(Perf_Counters));
+    if (options->perf_counters)
+    {
+        if (!perf_open(&update_perf))
+        {
+            printf("Perf error: couldn't open hardware counters (they need Linux, a PMU and perf_event_paranoid of 2 or less)\n");
+            return 1;
+        }
+
+        graph.phase_times.perf = &update_perf;
+    }
+
+    FILE *stats = NULL;
+    if (options->stats_path)
+    {
+        stats = fopen(options->stats_path, "wb");
+        if (!stats)
+        {
+            printf("Export error: couldn't write %s\n", options->stats_path);
+            return 1;
+        }
+
+        fprintf(stats, "generation,nodes,candidates,off_screen,far_cells,same_branch,close_ids,circle_tests,hits\n");
+    }
+
+    Divergence divergence = {0};
+    if (options->differential) graph.differential = &divergence;
+
+    Histogram generation_times = {0};
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    bool grown = grow_headless(&graph, options->stream_path ? &stream : NULL, options->checkpoint_path ? &checkpointer : NULL,
+        options->phase_log_path ? &log : NULL, stats, &generation_times);
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    if (options->checkpoint_path)
+    {
+        if (!checkpoint_finish(&checkpointer))
+        {
+            printf("Export error: couldn't write %s\n", options->checkpoint_path);
+            return 1;
+        }
+
+        double pause = (double)checkpointer.longest_pause * 1000 / SDL_GetPerformanceFrequency();
+        printf("wrote %d checkpoints to %s (longest pause %.2f ms)\n", checkpointer.written_count, options->checkpoint_path, pause);
+    }
+
+    if (graph.replay)
+    {
+        printf("replayed %d nodes in %.3f s (seed %u)\n", graph.node_count, seconds, graph.seed);
+
+        // Every recorded decision should have been used, no more and no fewer.
+        if (replayed.decision_count != replay_decision_count)
+        {
+            printf("Load error: %s replayed %llu of %llu decisions\n", options->replay_path,
+                (unsigned long long)replayed.decision_count, (unsigned long long)replay_decision_count);
+            return 1;
+        }
+    }
+    else
+    {
+        printf("grew %d nodes in %.3f s (seed %u)\n", graph.node_count, seconds, graph.seed);
+    }
+
+    if (generation_times.total > 0) print_histogram("generation", &generation_times, "generations");
+
+    if (options->differential)
+    {
+        print_divergence(&divergence);
+        memory_free(MEMORY_SCRATCH, divergence.indices, sizeof(int) * divergence.capacity);
+    }
+
+    if (stats)
+    {
+        write_collision_row(stats, "total", graph.node_count, &graph.total_collisions);
+
+        bool ok = !ferror(stats);
+        if (fclose(stats) != 0 || !ok)
+        {
+            printf("Export error: couldn't write %s\n", options->stats_path);
+            return 1;
+        }
+
+        Collision_Counts *total = &graph.total_collisions;
+        printf("tried %llu continuations: %llu off screen, %llu circle tests, %llu hits (%llu nodes skipped as far, %llu as same branch, %llu as close ids)\n",
+            (unsigned long long)total->candidates, (unsigned long long)total->off_screen, (unsigned long long)total->circle_tests,
+            (unsigned long long)total->hits, (unsigned long long)total->far_cells, (unsigned long long)total->same_branch,
+            (unsigned long long)total->close_ids);
+        printf("wrote %s\n", options->stats_path);
+    }
+
+    if (options->phase_log_path)
+    {
+        if (!phase_log_close(&log))
+        {
+            printf("Export error: couldn't write %s\n", options->phase_log_path);
+            return 1;
+        }
+
+        printf("wrote %s (%llu generations)\n", options->phase_log_path, (unsigned long long)log.row_count);
+    }
+
+    if (options->stream_path)
+    {
+        if (!stream_close(&stream) || !grown)
+        {
+            printf("Export error: couldn't write to %s\n", options->stream_path);
+            return 1;
+        }
+
+        printf("streamed %llu nodes in %llu bytes\n", (unsigned long long)stream.node_count, (unsigned long long)stream.byte_count);
+    }
+
+    Export_Source source = {0};
+    source.graph = &graph;
+    source.window = graph.window;
+    source.trace = graph.trace;
+    source.perf = options->perf_counters ? &export_perf : NULL;
+
+    if (options->frame_every > 0 && !write_frames(&graph, options)) return 1;
+    if (options->export_path && !write_png_export(&source, options)) return 1;
+    if (options->svg_path && !write_svg_export(&graph, options)) return 1;
+    if (options->dump_path && !write_dump(&graph, options)) return 1;
+
+    if (options->genome_path)
+    {
+        genome_end_record(&recorded);
+        if (!genome_save(&recorded, options->genome_path))
+        {
+            printf("Export error: couldn't write %s\n", options->genome_path);
+            return 1;
+        }
+
+        printf("wrote %s (%llu decisions in %d bytes)\n", options->genome_path, (unsigned long long)recorded.decision_count, (int)recorded.count);
+    }
+
+    genome_free(&recorded);
+    genome_free(&replayed);
+
+    if (options->perf_counters)
+    {
+        print_perf_counters(&update_perf, &export_perf, graph.node_count);
+        perf_close(&update_perf);
+    }
+
+    if (options->trace_path)
+    {
+        if (!trace_finish(&trace))
+        {
+            printf("Export error: couldn't write %s\n", options->trace_path);
+            return 1;
+        }
+
+        printf("wrote %s (%llu events, %llu dropped)\n", options->trace_path, (unsigned long long)trace.event_count, (unsigned long long)trace.dropped_count);
+    }
+
+    if (options->metrics_path)
+    {
+        metrics_finish(&metrics);
+        printf("answered %llu metrics requests on %s\n", (unsigned long long)metrics.request_count, options->metrics_path);
+    }
+
+    print_memory();
+
+    // A differential run that found a disagreement fails, once everything else is written.
+    return divergence.diverged ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parse_options(argc, argv, &options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    if (is_headless(&options))
+    {
+        return run_headless(&options);
+    }
+
+	SDL_Init(SDL_INIT_EVERYTHING);
+    IMG_Init(IMG_INIT_PNG);
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+    {
+        printf("SDL_Init video error: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    if (SDL_Init(SDL_INIT_AUDIO) != 0)
+    {
+        printf("SDL_Init audio error: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // SDL_ShowCursor(SDL_DISABLE);
+
+	// Setup window
+	SDL_Window *win = SDL_CreateWindow("Hyphae",
+			SDL_WINDOWPOS_CENTERED,
+			SDL_WINDOWPOS_CENTERED,
+			1440, 980,
+			SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+
+	// Setup renderer
+	SDL_Renderer *ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
+
+	// Setup font
+	TTF_Init();
+	TTF_Font *font = TTF_OpenFont("liberation.ttf", 12);
+	if (!font)
+	{
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error: Font", TTF_GetError(), win);
+		return -666;
+	}
+
+    // Setup main loop
+    bool quit = false;
+    bool do_iteration = true;
+
+    Simulation *sim = calloc(1, sizeof(Simulation));
+    Graph *graph = &sim->graph;
+    graph_init(graph, MAX_NODES);
+    graph->initial_point_count = 3;
+
+    // The render thread's view of the graph: the same nodes, but only as far as they've been committed.
+    Graph view = {0};
+    view.nodes = graph->nodes;
+    view.max_nodes = graph->max_nodes;
+
+    UI ui = {0};
+    ui.font = font;
+    ui.font_color = (SDL_Color){255, 255, 255, 255};
+    ui.show = true;
+    ui.quit = false;
+    ui.frames = 0;
+    ui.dirty = true;
+    ui.render_intermediate = true;
+    ui.camera.zoom = 1;
+
+    if (!build_glyph_atlas(ren, font, &ui.atlas))
+    {
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error: Font", SDL_GetError(), win);
+		return -666;
+    }
+
+    SDL_GetWindowSize(win, &view.window.x, &view.window.y);
+    SDL_AtomicSet(&sim->window_x, view.window.x);
+    SDL_AtomicSet(&sim->window_y, view.window.y);
+    SDL_AtomicSet(&sim->initial_point_count, graph->initial_point_count);
+    SDL_AtomicSet(&sim->requested_run, 1);
+    sim->wake = SDL_CreateSemaphore(0);
+    sim->committed_event = SDL_RegisterEvents(1);
+
+    Trace trace;
+    if (options.trace_path)
+    {
+        if (trace_start(&trace, options.trace_path))
+        {
+            trace_name_thread(&trace, "render");
+            graph->trace = &trace;
+            ui.trace = &trace;
+        }
+        else
+        {
+            printf("Export error: couldn't write %s\n", options.trace_path);
+            options.trace_path = NULL;
+        }
+    }
+
+    Metrics metrics;
+    if (options.metrics_path)
+    {
+        if (metrics_start(&metrics, options.metrics_path))
+        {
+            graph->metrics = &metrics;
+        }
+        else
+        {
+            printf("Metrics error: couldn't listen on %s\n", options.metrics_path);
+            options.metrics_path = NULL;
+        }
+    }
+
+    SDL_Thread *simulation_thread = SDL_CreateThread(simulate, "simulation", sim);
+
+    Phase_Log log;
+    if (options.phase_log_path && !phase_log_open(&log, options.phase_log_path))
+    {
+        printf("Export error: couldn't write %s\n", options.phase_log_path);
+        options.phase_log_path = NULL;
+    }
+
+    // Main loop
+    const float FPS_INTERVAL = 1.0f;
+    Uint64 fps_start, fps_current, fps_frames = 0;
+
+    fps_start = SDL_GetTicks();
+
+    while (!ui.quit)
+    {
+        // With nothing growing and nothing to redraw, sleep until there's input.
+        // Wake up when the fps counter is due so the overlay can show it dropping.
+        // The simulation thread posts an event whenever it commits something, so that counts as input too.
+        if (!ui.dirty)
+        {
+            int timeout = (int)(fps_start + FPS_INTERVAL * 1000) - (int)SDL_GetTicks();
+            SDL_WaitEventTimeout(NULL, timeout > 0 ? timeout : 0);
+        }
+
+        // A frame's time runs from here, once there's something to do, to when it's presented.
+        Uint64 frame_start = SDL_GetPerformanceCounter();
+
+        SDL_PumpEvents();
+        get_input(&ui, sim, &view, ren);
+
+        if (!ui.quit)
+        {
+            SDL_GetWindowSize(win, &view.window.x, &view.window.y);
+            SDL_AtomicSet(&sim->window_x, view.window.x);
+            SDL_AtomicSet(&sim->window_y, view.window.y);
+
+            drain_committed(sim, &view, &ui);
+            view.initial_point_count = SDL_AtomicGet(&sim->initial_point_count);
+
+            if (ui.dirty)
+            {
+                render(ren, view, &ui);
+                ui.dirty = false;
+
+                fps_frames++;
+                histogram_record_ticks(&ui.frame_times, SDL_GetPerformanceCounter() - frame_start);
+
+                if (options.phase_log_path)
+                {
+                    phase_log_write(&log, ui.frame_generation_count, &ui.frame_update_times, &ui.render_times);
+                    memset(&ui.frame_update_times, 0, sizeof(Phase_Times));
+                    ui.frame_generation_count = 0;
+                }
+            }
+
+            if (fps_start < SDL_GetTicks() - FPS_INTERVAL * 1000)
+            {
+                fps_start = SDL_GetTicks();
+                fps_current = fps_frames;
+                fps_frames = 0;
+
+                if (ui.frames != fps_current) ui.dirty = true;
+                ui.frames = fps_current;
+
+#ifdef PHASE_TIMING
+                phase_average_roll(&ui.update_average);
+                phase_average_roll(&ui.render_average);
+#endif
+                // printf("%I64d fps\n", fps_current);
+            }
+        }
+    }
+
+    SDL_AtomicSet(&sim->quit, 1);
+    SDL_SemPost(sim->wake);
+    SDL_WaitThread(simulation_thread, NULL);
+
+    if (options.phase_log_path) phase_log_close(&log);
+    if (options.trace_path) trace_finish(&trace);
+    if (options.metrics_path) metrics_finish(&metrics);
+
+    if (ui.frame_times.total > 0) print_histogram("frame", &ui.frame_times, "frames");
+    if (ui.generation_times.total > 0) print_histogram("generation", &ui.generation_times, "generations this run");
+    print_memory();
+
+	SDL_DestroyRenderer(ren);
+	SDL_DestroyWindow(win);
+	SDL_Quit();
+    return 0;
+}
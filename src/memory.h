@@ -0,0 +1,109 @@
+//
+// Memory accounting.
+// The big allocations go through memory_alloc, memory_realloc and memory_free
+// with a category, and each category keeps its current and peak bytes. Callers
+// pass the size back in when they let go, so the pointers stay plain malloc ones.
+// Memory that isn't malloc'd here (textures) is counted with memory_count. Pages
+// are made and let go of on several threads, so the counts are kept under a spin
+// lock; it's only taken once per allocation, and none of them are per node.
+//
+
+typedef enum {
+    MEMORY_NODES,
+    MEMORY_BRANCHES,
+    MEMORY_GRID,
+    MEMORY_FRONTIER,
+    MEMORY_SCRATCH,
+    MEMORY_TEXTURES,
+    MEMORY_FRAMEBUFFERS,
+
+    MEMORY_CATEGORY_COUNT
+} Memory_Category;
+
+const char *memory_category_names[MEMORY_CATEGORY_COUNT] = {
+    "nodes", "branches", "grid", "frontier", "scratch", "textures", "framebuffers",
+};
+
+typedef struct {
+    Sint64 current[MEMORY_CATEGORY_COUNT];
+    Sint64 peak[MEMORY_CATEGORY_COUNT];
+
+    // The most there's been of everything at once, which can be less than the peaks added up.
+    Sint64 total;
+    Sint64 total_peak;
+} Memory_Counts;
+
+SDL_SpinLock memory_lock;
+Memory_Counts memory_counts;
+
+// Add bytes (or take them away, if negative) to category.
+void memory_count(Memory_Category category, Sint64 bytes)
+{
+    SDL_AtomicLock(&memory_lock);
+
+    memory_counts.current[category] += bytes;
+    if (memory_counts.current[category] > memory_counts.peak[category]) memory_counts.peak[category] = memory_counts.current[category];
+
+    memory_counts.total += bytes;
+    if (memory_counts.total > memory_counts.total_peak) memory_counts.total_peak = memory_counts.total;
+
+    SDL_AtomicUnlock(&memory_lock);
+}
+
+void *memory_alloc(Memory_Category category, size_t size)
+{
+    void *memory = malloc(size);
+    if (memory) memory_count(category, size);
+    return memory;
+}
+
+void *memory_calloc(Memory_Category category, size_t count, size_t size)
+{
+    void *memory = calloc(count, size);
+    if (memory) memory_count(category, count * size);
+    return memory;
+}
+
+// Like realloc, given how big memory was; NULL and 0 for nothing yet.
+void *memory_realloc(Memory_Category category, void *memory, size_t old_size, size_t size)
+{
+    void *resized = realloc(memory, size);
+    if (resized) memory_count(category, (Sint64)size - (Sint64)old_size);
+    return resized;
+}
+
+void memory_free(Memory_Category category, void *memory, size_t size)
+{
+    if (!memory) return;
+
+    free(memory);
+    memory_count(category, -(Sint64)size);
+}
+
+// Start the peaks over from what's held now, so they cover only what comes next.
+void memory_reset_peaks(void)
+{
+    SDL_AtomicLock(&memory_lock);
+
+    for (int i = 0; i < MEMORY_CATEGORY_COUNT; i += 1)
+    {
+        memory_counts.peak[i] = memory_counts.current[i];
+    }
+    memory_counts.total_peak = memory_counts.total;
+
+    SDL_AtomicUnlock(&memory_lock);
+}
+
+// A consistent copy of every count.
+Memory_Counts memory_snapshot(void)
+{
+    SDL_AtomicLock(&memory_lock);
+    Memory_Counts counts = memory_counts;
+    SDL_AtomicUnlock(&memory_lock);
+    return counts;
+}
+
+double memory_megabytes(Sint64 bytes)
+{
+    return (double)bytes / (1024 * 1024);
+}
@@ -0,0 +1,196 @@
+//
+// Live metrics over a Unix domain socket.
+// The simulation publishes a sample after every generation into a seqlock: it
+// bumps the sequence to odd, copies the sample in and bumps it back to even, so
+// it never waits on anyone. A server thread accepts connections on the socket
+// and answers each with one JSON object and a newline, then hangs up. It copies
+// the sample out and starts again if the sequence moved while it was copying.
+// Windows has no such socket here, so metrics_start just fails there.
+//
+
+typedef struct {
+    int generation;
+    int node_count;
+    int active_point_count;
+    int max_nodes;
+
+    // Performance counter readings: when the run (or this resumption of it) started and when this was published.
+    Uint64 run_start;
+    Uint64 published;
+    int run_start_node_count;
+
+    Uint64 generation_ticks;
+    Uint64 phase_ticks[PHASE_COUNT];
+} Metrics_Sample;
+
+typedef struct {
+    SDL_atomic_t sequence;
+    Metrics_Sample sample;
+
+    // Only touched by the server.
+    const char *path;
+    int listener;
+    Uint64 request_count;
+
+    SDL_Thread *thread;
+    SDL_atomic_t quit;
+} Metrics;
+
+// Called by the one thread that grows the graph.
+void metrics_publish(Metrics *metrics, Metrics_Sample *sample)
+{
+    SDL_AtomicIncRef(&metrics->sequence);
+    SDL_MemoryBarrierRelease();
+
+    metrics->sample = *sample;
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicIncRef(&metrics->sequence);
+}
+
+Metrics_Sample metrics_read(Metrics *metrics)
+{
+    Metrics_Sample sample;
+    for (;;)
+    {
+        int before = SDL_AtomicGet(&metrics->sequence);
+        if (before & 1) continue;
+
+        SDL_MemoryBarrierAcquire();
+        sample = metrics->sample;
+        SDL_MemoryBarrierAcquire();
+
+        if (SDL_AtomicGet(&metrics->sequence) == before) return sample;
+    }
+}
+
+// The latest sample and what memory's held, as one line of JSON. Returns its length.
+int metrics_format(Metrics *metrics, char *buffer, int size)
+{
+    Metrics_Sample sample = metrics_read(metrics);
+    Memory_Counts memory = memory_snapshot();
+    double frequency = (double)SDL_GetPerformanceFrequency();
+
+    double seconds = sample.run_start ? (SDL_GetPerformanceCounter() - sample.run_start) / frequency : 0;
+    double grown_seconds = sample.run_start ? (sample.published - sample.run_start) / frequency : 0;
+    double nodes_per_second = grown_seconds > 0 ? (sample.node_count - sample.run_start_node_count) / grown_seconds : 0;
+
+    int length = snprintf(buffer, size, "{\"generation\": %d, \"node_count\": %d, \"active_point_count\": %d, \"max_nodes\": %d, "
+        "\"done\": %s, \"seconds\": %.3f, \"nodes_per_second\": %.1f, \"generation_ms\": %.4f, \"phase_ms\": {",
+        sample.generation, sample.node_count, sample.active_point_count, sample.max_nodes,
+        sample.generation > 0 && sample.active_point_count < 1 ? "true" : "false", seconds, nodes_per_second,
+        sample.generation_ticks * 1000 / frequency);
+
+#ifdef PHASE_TIMING
+    for (int i = 0; i < PHASE_FIRST_RENDER && length < size; i += 1)
+    {
+        length += snprintf(buffer + length, size - length, "%s\"%s\": %.4f", i > 0 ? ", " : "", phase_names[i], sample.phase_ticks[i] * 1000 / frequency);
+    }
+#endif
+
+    if (length < size) length += snprintf(buffer + length, size - length, "}, \"memory\": {");
+    for (int i = 0; i < MEMORY_CATEGORY_COUNT && length < size; i += 1)
+    {
+        length += snprintf(buffer + length, size - length, "\"%s\": {\"bytes\": %lld, \"peak_bytes\": %lld}, ", memory_category_names[i],
+            (long long)memory.current[i], (long long)memory.peak[i]);
+    }
+
+    if (length < size)
+    {
+        length += snprintf(buffer + length, size - length, "\"total\": {\"bytes\": %lld, \"peak_bytes\": %lld}}}\n",
+            (long long)memory.total, (long long)memory.total_peak);
+    }
+
+    return length < size ? length : size - 1;
+}
+
+#ifndef _WIN32
+
+int metrics_server(void *data)
+{
+    Metrics *metrics = data;
+    char response[2048];
+
+    while (!SDL_AtomicGet(&metrics->quit))
+    {
+        // Wake up every so often to see whether it's time to stop.
+        struct pollfd listening = {metrics->listener, POLLIN, 0};
+        if (poll(&listening, 1, 100) < 1) continue;
+
+        int client = accept(metrics->listener, NULL, NULL);
+        if (client < 0) continue;
+
+        // Whatever the client sends is the request, since there's only one answer. Take it all (as long
+        // as it comes soon) so none is left unread when the socket closes; clients can also just listen.
+        struct pollfd request = {client, POLLIN, 0};
+        int wait = 100;
+        char ignored[256];
+        while (poll(&request, 1, wait) > 0 && read(client, ignored, sizeof(ignored)) > 0) wait = 10;
+
+        int length = metrics_format(metrics, response, sizeof(response));
+        int written = 0;
+        while (written < length)
+        {
+            ssize_t count = write(client, response + written, length - written);
+            if (count <= 0) break;
+            written += (int)count;
+        }
+
+        close(client);
+        metrics->request_count += 1;
+    }
+
+    return 0;
+}
+
+// Listen on a socket at path, replacing whatever's there, and start answering.
+bool metrics_start(Metrics *metrics, const char *path)
+{
+    memset(metrics, 0, sizeof(Metrics));
+    metrics->path = path;
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) return false;
+    strcpy(address.sun_path, path);
+
+    metrics->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (metrics->listener < 0) return false;
+
+    unlink(path);
+    if (bind(metrics->listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(metrics->listener, 8) != 0)
+    {
+        close(metrics->listener);
+        return false;
+    }
+
+    // A monitor hanging up early mustn't take the whole run down with it.
+    signal(SIGPIPE, SIG_IGN);
+
+    metrics->thread = SDL_CreateThread(metrics_server, "metrics", metrics);
+    return true;
+}
+
+void metrics_finish(Metrics *metrics)
+{
+    SDL_AtomicSet(&metrics->quit, 1);
+    SDL_WaitThread(metrics->thread, NULL);
+
+    close(metrics->listener);
+    unlink(metrics->path);
+}
+
+#else
+
+bool metrics_start(Metrics *metrics, const char *path)
+{
+    memset(metrics, 0, sizeof(Metrics));
+    return false;
+}
+
+void metrics_finish(Metrics *metrics)
+{
+}
+
+#endif
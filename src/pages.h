@@ -0,0 +1,165 @@
+//
+// Copy-on-write pages.
+// A Paged_Array is a fixed directory of pointers to reference-counted pages of
+// PAGE_ITEMS items each. Forking one only copies the directory and bumps the
+// counts, so both copies share every page until one of them edits it, at which
+// point that page alone is copied. Reading never copies; editing through
+// paged_edit copies a shared page first, or makes a zeroed one if there's
+// nothing there yet. Counts are atomic, so forks can live on different threads.
+// Pages and directories are counted towards the array's memory category; a page
+// shared between forks is only counted once.
+//
+
+#define PAGE_SHIFT 10
+#define PAGE_ITEMS (1 << PAGE_SHIFT)
+
+// Whatever the page holds comes straight after this.
+typedef struct {
+    SDL_atomic_t references;
+    int size;
+    Memory_Category category;
+} Page;
+
+typedef struct {
+    Page **pages;
+    int page_count;
+    int item_size;
+    Memory_Category category;
+} Paged_Array;
+
+Page *page_create(int size, Memory_Category category)
+{
+    Page *page = memory_calloc(category, 1, sizeof(Page) + size);
+    SDL_AtomicSet(&page->references, 1);
+    page->size = size;
+    page->category = category;
+    return page;
+}
+
+void *page_data(Page *page)
+{
+    return page + 1;
+}
+
+bool page_shared(Page *page)
+{
+    return SDL_AtomicGet(&page->references) > 1;
+}
+
+void page_retain(Page *page)
+{
+    if (page) SDL_AtomicIncRef(&page->references);
+}
+
+void page_release(Page *page)
+{
+    if (page && SDL_AtomicDecRef(&page->references)) memory_free(page->category, page, sizeof(Page) + page->size);
+}
+
+// A private copy of page at size bytes (at least as big as it was), giving up this owner's reference to the original.
+Page *page_unshare(Page *page, int size)
+{
+    Page *copy = page_create(size, page->category);
+    memcpy(page_data(copy), page_data(page), page->size);
+    page_release(page);
+    return copy;
+}
+
+// Room for capacity items; no pages are made until they're edited.
+void paged_init(Paged_Array *array, int item_size, int capacity, Memory_Category category)
+{
+    array->item_size = item_size;
+    array->category = category;
+    array->page_count = (capacity + PAGE_ITEMS - 1) / PAGE_ITEMS;
+    if (array->page_count < 1) array->page_count = 1;
+    array->pages = memory_calloc(category, array->page_count, sizeof(Page *));
+}
+
+// Nothing there yet reads as NULL.
+void *paged_get(Paged_Array *array, int index)
+{
+    Page *page = array->pages[index >> PAGE_SHIFT];
+    if (!page) return NULL;
+
+    return (Uint8 *)page_data(page) + (size_t)(index & (PAGE_ITEMS - 1)) * array->item_size;
+}
+
+void *paged_edit(Paged_Array *array, int index)
+{
+    Page **page = &array->pages[index >> PAGE_SHIFT];
+
+    if (*page == NULL) *page = page_create(PAGE_ITEMS * array->item_size, array->category);
+    else if (page_shared(*page)) *page = page_unshare(*page, (*page)->size);
+
+    return (Uint8 *)page_data(*page) + (size_t)(index & (PAGE_ITEMS - 1)) * array->item_size;
+}
+
+// Make room for capacity items. The directory moves, so nothing else can be holding on to it.
+void paged_reserve(Paged_Array *array, int capacity)
+{
+    int page_count = (capacity + PAGE_ITEMS - 1) / PAGE_ITEMS;
+    if (page_count <= array->page_count) return;
+
+    if (page_count < array->page_count * 2) page_count = array->page_count * 2;
+    array->pages = memory_realloc(array->category, array->pages, sizeof(Page *) * array->page_count, sizeof(Page *) * page_count);
+    memset(array->pages + array->page_count, 0, sizeof(Page *) * (page_count - array->page_count));
+    array->page_count = page_count;
+}
+
+bool paged_shared(Paged_Array *array, int index)
+{
+    Page *page = array->pages[index >> PAGE_SHIFT];
+    return page && page_shared(page);
+}
+
+// Let go of every page, so the array reads as all zeros again once it's edited.
+void paged_clear(Paged_Array *array)
+{
+    for (int i = 0; i < array->page_count; i += 1)
+    {
+        page_release(array->pages[i]);
+        array->pages[i] = NULL;
+    }
+}
+
+void paged_fork(Paged_Array *fork, Paged_Array *array)
+{
+    *fork = *array;
+    fork->pages = memory_alloc(array->category, sizeof(Page *) * array->page_count);
+    memcpy(fork->pages, array->pages, sizeof(Page *) * array->page_count);
+
+    for (int i = 0; i < array->page_count; i += 1)
+    {
+        page_retain(array->pages[i]);
+    }
+}
+
+void paged_free(Paged_Array *array)
+{
+    if (array->pages) paged_clear(array);
+    memory_free(array->category, array->pages, sizeof(Page *) * array->page_count);
+    memset(array, 0, sizeof(Paged_Array));
+}
+
+// Bytes held by the directory and every page in it, shared or not.
+size_t paged_bytes(Paged_Array *array)
+{
+    size_t bytes = sizeof(Page *) * array->page_count;
+    for (int i = 0; i < array->page_count; i += 1)
+    {
+        if (array->pages[i]) bytes += sizeof(Page) + array->pages[i]->size;
+    }
+    return bytes;
+}
+
+// How many pages this array shares with some other fork, and how many are its own.
+void paged_count(Paged_Array *array, int *shared, int *owned)
+{
+    for (int i = 0; i < array->page_count; i += 1)
+    {
+        if (!array->pages[i]) continue;
+
+        if (page_shared(array->pages[i])) *shared += 1;
+        else *owned += 1;
+    }
+}
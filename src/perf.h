@@ -0,0 +1,159 @@
+//
+// Hardware performance counters, on Linux.
+// A group of counters (cycles, instructions, L1D read misses, last level cache
+// read misses and branch misses) is opened on the calling thread and read all at
+// once; each read's difference from the last goes to whichever phase just ended,
+// the same way the phase timers lap. Reading is a system call, so counting every
+// lap slows the run down a little and adds a little to what's counted.
+// Everywhere else perf_open just fails.
+//
+
+#define PERF_COUNTER_COUNT 5
+
+// Enough for every Phase and a few more.
+#define PERF_PHASE_MAX 16
+
+typedef struct {
+    int fds[PERF_COUNTER_COUNT];
+    bool opened[PERF_COUNTER_COUNT];
+    Uint64 last[PERF_COUNTER_COUNT];
+
+    Uint64 totals[PERF_PHASE_MAX][PERF_COUNTER_COUNT];
+    Uint64 laps[PERF_PHASE_MAX];
+} Perf_Counters;
+
+enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+};
+
+const char *perf_counter_names[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "L1D misses", "LLC misses", "branch misses",
+};
+
+#ifdef __linux__
+
+// Read every counter in the group into values; ones that didn't open stay 0.
+bool perf_read(Perf_Counters *perf, Uint64 *values)
+{
+    Uint64 buffer[1 + PERF_COUNTER_COUNT];
+    if (read(perf->fds[PERF_CYCLES], buffer, sizeof(buffer)) < (ssize_t)sizeof(Uint64)) return false;
+
+    // The group reads back as a count, then one value per counter in the order they joined.
+    Uint64 count = buffer[0];
+    Uint64 next = 0;
+    for (int i = 0; i < PERF_COUNTER_COUNT; i += 1)
+    {
+        values[i] = 0;
+        if (perf->opened[i] && next < count)
+        {
+            values[i] = buffer[1 + next];
+            next += 1;
+        }
+    }
+
+    return true;
+}
+
+// Start counting on this thread. Fails if there's no cycle counter to be had
+// (no PMU, as in many VMs, or perf_event_paranoid too high); the rest are optional.
+bool perf_open(Perf_Counters *perf)
+{
+    memset(perf, 0, sizeof(Perf_Counters));
+
+    Uint32 types[PERF_COUNTER_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+    Uint64 configs[PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i += 1)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[i];
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = i == PERF_CYCLES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        int group = i == PERF_CYCLES ? -1 : perf->fds[PERF_CYCLES];
+        perf->fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+        perf->opened[i] = perf->fds[i] >= 0;
+
+        if (i == PERF_CYCLES && !perf->opened[i]) return false;
+    }
+
+    ioctl(perf->fds[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf->fds[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    return perf_read(perf, perf->last);
+}
+
+void perf_close(Perf_Counters *perf)
+{
+    for (int i = 0; i < PERF_COUNTER_COUNT; i += 1)
+    {
+        if (perf->opened[i]) close(perf->fds[i]);
+        perf->opened[i] = false;
+    }
+}
+
+#else
+
+bool perf_open(Perf_Counters *perf)
+{
+    memset(perf, 0, sizeof(Perf_Counters));
+    return false;
+}
+
+bool perf_read(Perf_Counters *perf, Uint64 *values)
+{
+    return false;
+}
+
+void perf_close(Perf_Counters *perf)
+{
+}
+
+#endif
+
+// Put everything counted since the last lap down to phase.
+void perf_lap(Perf_Counters *perf, int phase)
+{
+    Uint64 now[PERF_COUNTER_COUNT];
+    if (!perf_read(perf, now)) return;
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i += 1)
+    {
+        perf->totals[phase][i] += now[i] - perf->last[i];
+        perf->last[i] = now[i];
+    }
+    perf->laps[phase] += 1;
+}
+
+// Add what from counted for each phase into into's totals.
+void perf_add(Perf_Counters *into, Perf_Counters *from)
+{
+    for (int phase = 0; phase < PERF_PHASE_MAX; phase += 1)
+    {
+        for (int i = 0; i < PERF_COUNTER_COUNT; i += 1)
+        {
+            into->totals[phase][i] += from->totals[phase][i];
+        }
+        into->laps[phase] += from->laps[phase];
+    }
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i += 1)
+    {
+        into->opened[i] = into->opened[i] || from->opened[i];
+    }
+}
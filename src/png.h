@@ -0,0 +1,240 @@
+//
+// Streaming PNG writer.
+// The image is split into horizontal strips of rows. Each strip is filtered and
+// deflated on its own (so strips can be encoded on any thread), then written
+// out in order as IDAT chunks. Only strips that haven't been written yet are
+// held in memory. Output is 8-bit RGB, every row filtered with Sub.
+//
+
+#define PNG_IDAT_SIZE 65536
+
+typedef struct {
+    Byte_Buffer compressed;
+    Uint32 adler;
+    size_t filtered_size;
+    int row_count;
+    bool ready;
+} Png_Strip;
+
+typedef struct {
+    FILE *file;
+    int width;
+    int height;
+    int rows_written;
+
+    Byte_Buffer pending;
+    Uint32 adler;
+} Png_Writer;
+
+Uint32 png_crc_table[256];
+bool png_crc_table_ready = false;
+
+Uint32 png_crc(Uint32 crc, const Uint8 *bytes, size_t count)
+{
+    if (!png_crc_table_ready)
+    {
+        for (Uint32 n = 0; n < 256; n += 1)
+        {
+            Uint32 c = n;
+            for (int k = 0; k < 8; k += 1)
+            {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            png_crc_table[n] = c;
+        }
+        png_crc_table_ready = true;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < count; i += 1)
+    {
+        crc = png_crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+Uint32 png_adler(Uint32 adler, const Uint8 *bytes, size_t count)
+{
+    Uint32 a = adler & 0xFFFF;
+    Uint32 b = adler >> 16;
+
+    while (count > 0)
+    {
+        // 5552 is the most bytes that can be summed before b could overflow.
+        size_t block = count < 5552 ? count : 5552;
+        for (size_t i = 0; i < block; i += 1)
+        {
+            a += bytes[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+
+        bytes += block;
+        count -= block;
+    }
+
+    return (b << 16) | a;
+}
+
+// The Adler-32 of two byte runs back to back, given each one's and the second's length.
+Uint32 png_adler_combine(Uint32 adler1, Uint32 adler2, size_t length2)
+{
+    Uint32 remainder = (Uint32)(length2 % 65521);
+    Uint32 a = adler1 & 0xFFFF;
+    Uint32 b = (Uint32)(((Uint64)remainder * a) % 65521);
+
+    a += (adler2 & 0xFFFF) + 65521 - 1;
+    b += (adler1 >> 16) + (adler2 >> 16) + 65521 - remainder;
+
+    if (a >= 65521) a -= 65521;
+    if (a >= 65521) a -= 65521;
+    if (b >= 65521 * 2) b -= 65521 * 2;
+    if (b >= 65521) b -= 65521;
+
+    return (b << 16) | a;
+}
+
+void png_put_u32(Uint8 *bytes, Uint32 value)
+{
+    bytes[0] = (Uint8)(value >> 24);
+    bytes[1] = (Uint8)(value >> 16);
+    bytes[2] = (Uint8)(value >> 8);
+    bytes[3] = (Uint8)value;
+}
+
+void png_write_chunk(FILE *file, const char *type, const Uint8 *data, size_t count)
+{
+    Uint8 length[4];
+    png_put_u32(length, (Uint32)count);
+    fwrite(length, 1, 4, file);
+    fwrite(type, 1, 4, file);
+    if (count > 0) fwrite(data, 1, count, file);
+
+    Uint32 crc = png_crc(0, (const Uint8 *)type, 4);
+    crc = png_crc(crc, data, count);
+
+    Uint8 crc_bytes[4];
+    png_put_u32(crc_bytes, crc);
+    fwrite(crc_bytes, 1, 4, file);
+}
+
+// Write out whole IDAT chunks of pending compressed data, or everything if finishing.
+void png_flush_idat(Png_Writer *png, bool everything)
+{
+    Byte_Buffer *pending = &png->pending;
+
+    size_t written = 0;
+    while (pending->count - written >= PNG_IDAT_SIZE || (everything && pending->count > written))
+    {
+        size_t count = pending->count - written;
+        if (count > PNG_IDAT_SIZE) count = PNG_IDAT_SIZE;
+
+        png_write_chunk(png->file, "IDAT", pending->bytes + written, count);
+        written += count;
+    }
+
+    memmove(pending->bytes, pending->bytes + written, pending->count - written);
+    pending->count -= written;
+}
+
+bool png_begin(Png_Writer *png, const char *path, int width, int height)
+{
+    png->file = fopen(path, "wb");
+    if (!png->file) return false;
+
+    png->width = width;
+    png->height = height;
+    png->rows_written = 0;
+    png->pending = (Byte_Buffer){0};
+    png->adler = 1;
+
+    static const Uint8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, 8, png->file);
+
+    Uint8 header[13];
+    png_put_u32(header + 0, width);
+    png_put_u32(header + 4, height);
+    header[8] = 8;   // Bit depth.
+    header[9] = 2;   // Color type: RGB.
+    header[10] = 0;  // Compression: deflate.
+    header[11] = 0;  // Filter method: adaptive.
+    header[12] = 0;  // No interlacing.
+    png_write_chunk(png->file, "IHDR", header, 13);
+
+    // zlib header: deflate with a 32K window, no preset dictionary.
+    static const Uint8 zlib_header[2] = {0x78, 0x01};
+    byte_buffer_append(&png->pending, zlib_header, 2);
+
+    return true;
+}
+
+// Sub-filter one row of RGB pixels.
+void png_filter_row(Uint8 *filtered, const Uint8 *row, int width)
+{
+    filtered[0] = 1;
+    for (int i = 0; i < 3 && i < width * 3; i += 1)
+    {
+        filtered[1 + i] = row[i];
+    }
+    for (int i = 3; i < width * 3; i += 1)
+    {
+        filtered[1 + i] = row[i] - row[i - 3];
+    }
+}
+
+// Filter and compress rows into strip, using d and filtered (1 + width * 3 bytes) as scratch.
+// Touches nothing shared, so any number of strips can be encoded at once.
+void png_encode_strip(Deflate *d, Uint8 *filtered, const Uint8 *rows, int width, int row_count, Png_Strip *strip)
+{
+    size_t filtered_size = 1 + (size_t)width * 3;
+
+    // Take over the strip's buffer so its allocation gets reused.
+    Byte_Buffer spare = d->out;
+    d->out = strip->compressed;
+    deflate_init(d);
+
+    strip->adler = 1;
+    for (int y = 0; y < row_count; y += 1)
+    {
+        png_filter_row(filtered, rows + (size_t)y * width * 3, width);
+        strip->adler = png_adler(strip->adler, filtered, filtered_size);
+        deflate_write(d, filtered, filtered_size);
+    }
+    deflate_sync(d);
+
+    strip->compressed = d->out;
+    strip->filtered_size = filtered_size * row_count;
+    strip->row_count = row_count;
+    d->out = spare;
+}
+
+// Strips have to be written top to bottom.
+void png_write_strip(Png_Writer *png, Png_Strip *strip)
+{
+    byte_buffer_append(&png->pending, strip->compressed.bytes, strip->compressed.count);
+    strip->compressed.count = 0;
+
+    png->adler = png_adler_combine(png->adler, strip->adler, strip->filtered_size);
+    png->rows_written += strip->row_count;
+
+    png_flush_idat(png, false);
+}
+
+bool png_end(Png_Writer *png)
+{
+    byte_buffer_append(&png->pending, deflate_final_block, sizeof(deflate_final_block));
+
+    Uint8 adler[4];
+    png_put_u32(adler, png->adler);
+    byte_buffer_append(&png->pending, adler, 4);
+
+    png_flush_idat(png, true);
+    png_write_chunk(png->file, "IEND", NULL, 0);
+
+    bool ok = png->rows_written == png->height && !ferror(png->file);
+    fclose(png->file);
+    byte_buffer_free(&png->pending);
+
+    return ok;
+}
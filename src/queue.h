@@ -0,0 +1,49 @@
+//
+// Single-producer/single-consumer ring of committed node ranges.
+// The simulation thread pushes, the render thread pops. Neither side locks;
+// each only ever writes its own end, and SDL's atomics order the slot
+// contents against the index that publishes them.
+//
+
+#define RANGE_QUEUE_CAPACITY 256
+
+typedef struct {
+    int run;
+    int start;
+    int end;
+    int active_point_count;
+    int generation;
+    Phase_Times phase_times;
+    Uint64 generation_ticks;
+    Collision_Counts collisions;
+} Committed_Range;
+
+typedef struct {
+    Committed_Range items[RANGE_QUEUE_CAPACITY];
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+} Range_Queue;
+
+bool range_queue_push(Range_Queue *queue, Committed_Range range)
+{
+    int tail = SDL_AtomicGet(&queue->tail);
+    if (tail - SDL_AtomicGet(&queue->head) == RANGE_QUEUE_CAPACITY) return false;
+
+    queue->items[tail % RANGE_QUEUE_CAPACITY] = range;
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->tail, tail + 1);
+    return true;
+}
+
+bool range_queue_pop(Range_Queue *queue, Committed_Range *range)
+{
+    int head = SDL_AtomicGet(&queue->head);
+    if (head == SDL_AtomicGet(&queue->tail)) return false;
+
+    SDL_MemoryBarrierAcquire();
+    *range = queue->items[head % RANGE_QUEUE_CAPACITY];
+
+    SDL_AtomicSet(&queue->head, head + 1);
+    return true;
+}
@@ -0,0 +1,172 @@
+//
+// Streaming node output.
+// Each generation's committed nodes go out as soon as it's done, packed small
+// enough to pipe into other tools, and flushed so a reader can draw as they come.
+//
+// Stream: "HYPS", version byte, then varints window width, height and the seed.
+// Then per generation, one record per node followed by a 00 byte. A generation
+// with no nodes ends the stream. Per node:
+//
+//   varint  (index - parent) << 1 | starts_branch   (parent distance 0 for an initial point)
+//   varint  zigzag x, zigzag y                      in 1/16 px, from the parent (or from 0, 0)
+//   if starts_branch:
+//   varint  zigzag branch id, from the previous branch started in the stream
+//   varint  radius
+//   byte    r, g, b
+//
+// Otherwise a node has its parent's branch, radius and color.
+//
+
+#define STREAM_VERSION 1
+#define STREAM_SUBPIXELS 16
+
+typedef struct {
+    FILE *file;
+    Byte_Buffer buffer;
+
+    // Positions as written, so offsets are taken from what the reader has and never drift.
+    Sint32 *x;
+    Sint32 *y;
+    int capacity;
+
+    int last_branch;
+    Uint64 node_count;
+    Uint64 byte_count;
+} Node_Stream;
+
+void stream_put_varint(Byte_Buffer *buffer, Uint64 value)
+{
+    Uint8 bytes[10];
+    int count = 0;
+
+    while (value >= 0x80)
+    {
+        bytes[count] = (Uint8)(value | 0x80);
+        count += 1;
+        value >>= 7;
+    }
+    bytes[count] = (Uint8)value;
+    count += 1;
+
+    byte_buffer_append(buffer, bytes, count);
+}
+
+Uint64 stream_zigzag(Sint64 value)
+{
+    return ((Uint64)value << 1) ^ (Uint64)(value >> 63);
+}
+
+Sint32 stream_quantize(float value)
+{
+    return (Sint32)floor(value * STREAM_SUBPIXELS + 0.5);
+}
+
+// Write out and flush whatever's been packed so far.
+bool stream_flush(Node_Stream *stream)
+{
+    fwrite(stream->buffer.bytes, 1, stream->buffer.count, stream->file);
+    fflush(stream->file);
+
+    stream->byte_count += stream->buffer.count;
+    stream->buffer.count = 0;
+
+    return !ferror(stream->file);
+}
+
+// A path of "-" streams to stdout, and everything else that would have been printed goes to stderr instead.
+bool stream_open(Node_Stream *stream, const char *path, Window window, unsigned int seed)
+{
+    memset(stream, 0, sizeof(Node_Stream));
+
+    if (strcmp(path, "-") == 0)
+    {
+        fflush(stdout);
+#ifdef _WIN32
+        int fd = _dup(_fileno(stdout));
+        _dup2(_fileno(stderr), _fileno(stdout));
+        _setmode(fd, _O_BINARY);
+        stream->file = _fdopen(fd, "wb");
+#else
+        int fd = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        stream->file = fdopen(fd, "wb");
+#endif
+    }
+    else
+    {
+        stream->file = fopen(path, "wb");
+    }
+
+    if (!stream->file) return false;
+
+    byte_buffer_append(&stream->buffer, "HYPS", 4);
+    Uint8 version = STREAM_VERSION;
+    byte_buffer_append(&stream->buffer, &version, 1);
+    stream_put_varint(&stream->buffer, window.x);
+    stream_put_varint(&stream->buffer, window.y);
+    stream_put_varint(&stream->buffer, seed);
+
+    return stream_flush(stream);
+}
+
+// Pack nodes [start, end) as one generation and send it.
+bool stream_generation(Node_Stream *stream, Graph *graph, int start, int end)
+{
+    if (end > stream->capacity)
+    {
+        int capacity = end * 2;
+        stream->x = memory_realloc(MEMORY_SCRATCH, stream->x, sizeof(Sint32) * stream->capacity, sizeof(Sint32) * capacity);
+        stream->y = memory_realloc(MEMORY_SCRATCH, stream->y, sizeof(Sint32) * stream->capacity, sizeof(Sint32) * capacity);
+        stream->capacity = capacity;
+    }
+
+    Byte_Buffer *buffer = &stream->buffer;
+    for (int i = start; i < end; i += 1)
+    {
+        Node *node = graph_node(graph, i);
+        Node *parent = node->parent >= 0 ? graph_node(graph, node->parent) : NULL;
+        bool starts_branch = !parent || parent->branch != node->branch;
+
+        stream->x[i] = stream_quantize(node->circle.center.x);
+        stream->y[i] = stream_quantize(node->circle.center.y);
+
+        Sint32 from_x = parent ? stream->x[node->parent] : 0;
+        Sint32 from_y = parent ? stream->y[node->parent] : 0;
+
+        stream_put_varint(buffer, ((Uint64)(parent ? i - node->parent : 0) << 1) | starts_branch);
+        stream_put_varint(buffer, stream_zigzag(stream->x[i] - from_x));
+        stream_put_varint(buffer, stream_zigzag(stream->y[i] - from_y));
+
+        if (starts_branch)
+        {
+            stream_put_varint(buffer, stream_zigzag(node->branch - stream->last_branch));
+            stream_put_varint(buffer, node->circle.radius);
+
+            Uint8 color[3] = {node->color.r, node->color.g, node->color.b};
+            byte_buffer_append(buffer, color, 3);
+
+            stream->last_branch = node->branch;
+        }
+    }
+
+    Uint8 end_of_generation = 0;
+    byte_buffer_append(buffer, &end_of_generation, 1);
+
+    stream->node_count += end - start;
+    return stream_flush(stream);
+}
+
+bool stream_close(Node_Stream *stream)
+{
+    // An empty generation.
+    Uint8 end_of_stream = 0;
+    byte_buffer_append(&stream->buffer, &end_of_stream, 1);
+    bool ok = stream_flush(stream);
+
+    if (fclose(stream->file) != 0) ok = false;
+    byte_buffer_free(&stream->buffer);
+    memory_free(MEMORY_SCRATCH, stream->x, sizeof(Sint32) * stream->capacity);
+    memory_free(MEMORY_SCRATCH, stream->y, sizeof(Sint32) * stream->capacity);
+
+    return ok;
+}
@@ -0,0 +1,122 @@
+//
+// Headless SVG export.
+// Every node in a branch has the same radius and color and the branch only ever
+// grows from its tip, so a whole branch goes out as one round-capped polyline
+// as wide as its nodes, instead of one circle per node.
+//
+
+// Distance from p to the segment a-b.
+float segment_distance(vec2 p, vec2 a, vec2 b)
+{
+    vec2 ab = vec2_subtract(b, a);
+    vec2 ap = vec2_subtract(p, a);
+
+    float length_squared = vec2_dot_product(ab, ab);
+    float t = length_squared > 0 ? vec2_dot_product(ap, ab) / length_squared : 0;
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+
+    return vec2_length(vec2_subtract(ap, vec2_scalar_multiply(ab, t)));
+}
+
+// Douglas-Peucker: mark the points that keep the polyline within tolerance of the original.
+// stack needs room for 2 * count ints. Branches can be thousands of nodes long, so no recursion.
+void simplify_polyline(vec2 *points, int count, float tolerance, bool *keep, int *stack)
+{
+    for (int i = 0; i < count; i += 1) keep[i] = tolerance <= 0;
+    keep[0] = true;
+    keep[count - 1] = true;
+    if (tolerance <= 0 || count < 3) return;
+
+    int stack_count = 0;
+    stack[stack_count++] = 0;
+    stack[stack_count++] = count - 1;
+
+    while (stack_count > 0)
+    {
+        int last = stack[--stack_count];
+        int first = stack[--stack_count];
+
+        int farthest = -1;
+        float farthest_distance = tolerance;
+        for (int i = first + 1; i < last; i += 1)
+        {
+            float distance = segment_distance(points[i], points[first], points[last]);
+            if (distance > farthest_distance)
+            {
+                farthest = i;
+                farthest_distance = distance;
+            }
+        }
+
+        if (farthest < 0) continue;
+
+        keep[farthest] = true;
+        stack[stack_count++] = first;
+        stack[stack_count++] = farthest;
+        stack[stack_count++] = farthest;
+        stack[stack_count++] = last;
+    }
+}
+
+bool export_svg(Graph *graph, const char *path, float tolerance)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+
+    size_t room = graph->node_count + 1;
+    int *chain = memory_alloc(MEMORY_SCRATCH, sizeof(int) * room);
+    vec2 *points = memory_alloc(MEMORY_SCRATCH, sizeof(vec2) * room);
+    bool *keep = memory_alloc(MEMORY_SCRATCH, sizeof(bool) * room);
+    int *stack = memory_alloc(MEMORY_SCRATCH, sizeof(int) * 2 * room);
+
+    fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+        graph->window.x, graph->window.y, graph->window.x, graph->window.y);
+    fprintf(file, "<rect width=\"100%%\" height=\"100%%\" fill=\"black\"/>\n");
+    fprintf(file, "<g fill=\"none\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n");
+
+    int element_count = 0;
+    for (int b = 1; b < graph->next_branch; b += 1)
+    {
+        int count = branch_chain(graph, b, chain);
+        if (count == 0) continue;
+
+        Node *first = graph_node(graph, chain[0]);
+        SDL_Color color = first->color;
+
+        if (count == 1)
+        {
+            fprintf(file, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"%d\" fill=\"rgb(%d,%d,%d)\"/>\n",
+                first->circle.center.x, first->circle.center.y, first->circle.radius, color.r, color.g, color.b);
+            element_count += 1;
+            continue;
+        }
+
+        for (int i = 0; i < count; i += 1)
+        {
+            points[i] = graph_node(graph, chain[i])->circle.center;
+        }
+        simplify_polyline(points, count, tolerance, keep, stack);
+
+        fprintf(file, "<polyline stroke=\"rgb(%d,%d,%d)\" stroke-width=\"%d\" points=\"", color.r, color.g, color.b, first->circle.radius * 2);
+        for (int i = 0; i < count; i += 1)
+        {
+            if (keep[i]) fprintf(file, "%.1f,%.1f ", points[i].x, points[i].y);
+        }
+        fprintf(file, "\"/>\n");
+        element_count += 1;
+    }
+
+    fprintf(file, "</g>\n</svg>\n");
+
+    printf("wrote %d elements for %d nodes\n", element_count, graph->node_count);
+
+    memory_free(MEMORY_SCRATCH, stack, sizeof(int) * 2 * room);
+    memory_free(MEMORY_SCRATCH, keep, sizeof(bool) * room);
+    memory_free(MEMORY_SCRATCH, points, sizeof(vec2) * room);
+    memory_free(MEMORY_SCRATCH, chain, sizeof(int) * room);
+
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
@@ -0,0 +1,119 @@
+//
+// Glyph atlas text.
+// Every printable ASCII glyph is rendered once at startup into a single texture,
+// and strings are drawn as one quad per character out of it.
+//
+
+#define GLYPH_FIRST 32
+#define GLYPH_LAST 126
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+
+#define GLYPH_ATLAS_WIDTH 256
+
+#define TEXT_LINE_MAX 256
+
+typedef struct {
+    SDL_Texture *texture;
+    SDL_Rect glyphs[GLYPH_COUNT];
+    int line_height;
+} Glyph_Atlas;
+
+typedef struct {
+    char string[TEXT_LINE_MAX];
+    SDL_Rect sources[TEXT_LINE_MAX];
+    SDL_Rect destinations[TEXT_LINE_MAX];
+    int quad_count;
+} Text_Line;
+
+bool build_glyph_atlas(SDL_Renderer *renderer, TTF_Font *font, Glyph_Atlas *atlas)
+{
+    SDL_Surface *surfaces[GLYPH_COUNT];
+    SDL_Color white = {255, 255, 255, 255};
+
+    atlas->line_height = TTF_FontHeight(font);
+
+    // Render each glyph once and work out where it goes in the atlas.
+    int x = 0;
+    int y = 0;
+    for (int i = 0; i < GLYPH_COUNT; i += 1)
+    {
+        char string[2] = {(char)(GLYPH_FIRST + i), '\0'};
+        surfaces[i] = TTF_RenderText_Blended(font, string, white);
+
+        int w = surfaces[i] ? surfaces[i]->w : 0;
+        if (x + w > GLYPH_ATLAS_WIDTH)
+        {
+            x = 0;
+            y += atlas->line_height;
+        }
+
+        atlas->glyphs[i] = (SDL_Rect){x, y, w, atlas->line_height};
+        x += w;
+    }
+
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_ATLAS_WIDTH, y + atlas->line_height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!sheet) return false;
+
+    for (int i = 0; i < GLYPH_COUNT; i += 1)
+    {
+        if (!surfaces[i]) continue;
+
+        // Copy the glyph's alpha straight across instead of blending it onto the empty sheet.
+        SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(surfaces[i], NULL, sheet, &atlas->glyphs[i]);
+        SDL_FreeSurface(surfaces[i]);
+    }
+
+    atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    if (atlas->texture) memory_count(MEMORY_TEXTURES, (Sint64)sheet->w * sheet->h * 4);
+    SDL_FreeSurface(sheet);
+    if (!atlas->texture) return false;
+
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+
+    return true;
+}
+
+// Lay out a line of text at (x, y). The quads are only rebuilt when the string changes.
+void set_text(Text_Line *line, Glyph_Atlas *atlas, int x, int y, const char *format, ...)
+{
+    char string[TEXT_LINE_MAX];
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(string, TEXT_LINE_MAX, format, args);
+    va_end(args);
+
+    if (strcmp(string, line->string) == 0) return;
+
+    strcpy(line->string, string);
+    line->quad_count = 0;
+
+    int pen_x = x;
+    for (char *c = line->string; *c; c += 1)
+    {
+        int glyph = *c;
+        if (glyph < GLYPH_FIRST || glyph > GLYPH_LAST) glyph = '?';
+
+        SDL_Rect source = atlas->glyphs[glyph - GLYPH_FIRST];
+        if (source.w > 0 && glyph != ' ')
+        {
+            line->sources[line->quad_count] = source;
+            line->destinations[line->quad_count] = (SDL_Rect){pen_x, y, source.w, source.h};
+            line->quad_count += 1;
+        }
+
+        pen_x += source.w;
+    }
+}
+
+void draw_text(SDL_Renderer *renderer, Glyph_Atlas *atlas, Text_Line *line, SDL_Color font_color)
+{
+    SDL_SetTextureColorMod(atlas->texture, font_color.r, font_color.g, font_color.b);
+    SDL_SetTextureAlphaMod(atlas->texture, font_color.a);
+
+    for (int i = 0; i < line->quad_count; i += 1)
+    {
+        SDL_RenderCopy(renderer, atlas->texture, &line->sources[i], &line->destinations[i]);
+    }
+}
@@ -0,0 +1,154 @@
+//
+// Per-phase timing.
+// Each phase is timed as a lap of one clock: when a phase ends, the time since the
+// last lap is added to it, so a boundary costs one counter read. Without
+// PHASE_TIMING defined the macros compile to nothing, so they can stay in.
+//
+
+#define PHASE_TIMING
+// #undef PHASE_TIMING
+
+typedef enum {
+    // update()
+    PHASE_INIT,
+    PHASE_CANDIDATES,
+    PHASE_BOUNDS,
+    PHASE_COLLISION,
+    PHASE_SPAWN,
+    PHASE_COMMIT,
+
+    // render()
+    PHASE_SORT,
+    PHASE_DRAW,
+    PHASE_TEXT,
+    PHASE_PRESENT,
+
+    PHASE_COUNT
+} Phase;
+
+#define PHASE_FIRST_RENDER PHASE_SORT
+
+const char *phase_names[PHASE_COUNT] = {
+    "init", "candidates", "bounds", "collision", "spawn", "commit",
+    "sort", "draw", "text", "present",
+};
+
+typedef struct {
+    Uint64 ticks[PHASE_COUNT];
+
+    // When the last lap ended.
+    Uint64 clock;
+
+    // If set, hardware counters are lapped along with the clock.
+    Perf_Counters *perf;
+} Phase_Times;
+
+// Laps summed over a while, and what they came to per count the last time that was rolled over.
+typedef struct {
+    Phase_Times sum;
+    int count;
+    double milliseconds[PHASE_COUNT];
+} Phase_Average;
+
+typedef struct {
+    FILE *file;
+    Uint64 row_count;
+} Phase_Log;
+
+#ifdef PHASE_TIMING
+#define PHASE_START(times) phase_start(times)
+#define PHASE_LAP(times, phase) phase_lap((times), (phase))
+#else
+#define PHASE_START(times)
+#define PHASE_LAP(times, phase)
+#endif
+
+// Zero times and start its clock.
+void phase_start(Phase_Times *times)
+{
+    memset(times->ticks, 0, sizeof(times->ticks));
+    times->clock = SDL_GetPerformanceCounter();
+
+    // Nothing from before the start counts towards the first phase.
+    if (times->perf) perf_read(times->perf, times->perf->last);
+}
+
+void phase_lap(Phase_Times *times, Phase phase)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    times->ticks[phase] += now - times->clock;
+    times->clock = now;
+
+    if (times->perf) perf_lap(times->perf, phase);
+}
+
+double phase_total_milliseconds(double *milliseconds, Phase first, Phase last)
+{
+    double total = 0;
+    for (Phase i = first; i <= last; i += 1) total += milliseconds[i];
+    return total;
+}
+
+void phase_average_add(Phase_Average *average, Phase_Times *times)
+{
+    for (int i = 0; i < PHASE_COUNT; i += 1)
+    {
+        average->sum.ticks[i] += times->ticks[i];
+    }
+    average->count += 1;
+}
+
+// Work out what the laps since the last roll came to per count, and start summing again.
+// Keeps the last averages if nothing was added meanwhile.
+void phase_average_roll(Phase_Average *average)
+{
+    if (average->count == 0) return;
+
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    for (int i = 0; i < PHASE_COUNT; i += 1)
+    {
+        average->milliseconds[i] = average->sum.ticks[i] * 1000 / frequency / average->count;
+    }
+
+    memset(&average->sum, 0, sizeof(Phase_Times));
+    average->count = 0;
+}
+
+bool phase_log_open(Phase_Log *log, const char *path)
+{
+    log->file = fopen(path, "wb");
+    log->row_count = 0;
+    if (!log->file) return false;
+
+    fprintf(log->file, "row,generations");
+    for (int i = 0; i < PHASE_COUNT; i += 1)
+    {
+        fprintf(log->file, ",%s_ms", phase_names[i]);
+    }
+    fprintf(log->file, "\n");
+
+    return !ferror(log->file);
+}
+
+// One row: the update() phases summed over generation_count generations, then the render() phases.
+void phase_log_write(Phase_Log *log, int generation_count, Phase_Times *update_times, Phase_Times *render_times)
+{
+    double frequency = (double)SDL_GetPerformanceFrequency();
+
+    fprintf(log->file, "%llu,%d", (unsigned long long)log->row_count, generation_count);
+    for (int i = 0; i < PHASE_COUNT; i += 1)
+    {
+        Phase_Times *times = i < PHASE_FIRST_RENDER ? update_times : render_times;
+        fprintf(log->file, ",%.4f", times ? times->ticks[i] * 1000 / frequency : 0);
+    }
+    fprintf(log->file, "\n");
+
+    log->row_count += 1;
+}
+
+bool phase_log_close(Phase_Log *log)
+{
+    bool ok = !ferror(log->file);
+    if (fclose(log->file) != 0) ok = false;
+    return ok;
+}
@@ -0,0 +1,186 @@
+//
+// Chrome trace-event output, for chrome://tracing or Perfetto.
+// Any thread can add spans; they're only copied into a buffer under a lock, and
+// a writer thread swaps the buffer out and formats and writes it in the
+// background. If the writer falls that far behind, new spans are dropped
+// (and counted) rather than holding the caller up.
+//
+
+#define TRACE_BUFFER_EVENTS 16384
+
+typedef struct {
+    // Names and categories have to outlive the trace.
+    const char *name;
+    const char *category;
+
+    // 'X' for a span, 'M' to name the thread.
+    char kind;
+    SDL_threadID thread;
+    Uint64 start;
+    Uint64 end;
+
+    // Generation, frame or band, and a node count, or -1 when there isn't one.
+    int number;
+    int node_count;
+} Trace_Event;
+
+typedef struct {
+    FILE *file;
+    bool first;
+    bool failed;
+
+    Uint64 origin;
+    Uint64 frequency;
+
+    SDL_mutex *lock;
+    Trace_Event *filling;
+    int filling_count;
+    Uint64 event_count;
+    Uint64 dropped_count;
+
+    // Only touched by the writer.
+    Trace_Event *writing;
+
+    SDL_Thread *thread;
+    SDL_sem *wake;
+    SDL_atomic_t quit;
+} Trace;
+
+void trace_add(Trace *trace, Trace_Event event)
+{
+    SDL_LockMutex(trace->lock);
+
+    if (trace->filling_count == TRACE_BUFFER_EVENTS)
+    {
+        trace->dropped_count += 1;
+    }
+    else
+    {
+        trace->filling[trace->filling_count] = event;
+        trace->filling_count += 1;
+        trace->event_count += 1;
+
+        // Wake the writer while there's still room to carry on.
+        if (trace->filling_count == TRACE_BUFFER_EVENTS / 2) SDL_SemPost(trace->wake);
+    }
+
+    SDL_UnlockMutex(trace->lock);
+}
+
+// A span on this thread from start to end, both performance counter readings.
+void trace_span(Trace *trace, const char *category, const char *name, Uint64 start, Uint64 end, int number, int node_count)
+{
+    Trace_Event event = {name, category, 'X', SDL_ThreadID(), start, end, number, node_count};
+    trace_add(trace, event);
+}
+
+void trace_name_thread(Trace *trace, const char *name)
+{
+    Trace_Event event = {name, "", 'M', SDL_ThreadID(), 0, 0, -1, -1};
+    trace_add(trace, event);
+}
+
+// Phases first to last of times, as spans laid end to end from start. Phases that are
+// lapped many times over (once per node, say) are shown as their totals.
+void trace_phases(Trace *trace, const char *category, Uint64 start, Phase_Times *times, Phase first, Phase last, int number)
+{
+    for (Phase i = first; i <= last; i += 1)
+    {
+        if (times->ticks[i] == 0) continue;
+
+        trace_span(trace, category, phase_names[i], start, start + times->ticks[i], number, -1);
+        start += times->ticks[i];
+    }
+}
+
+void trace_write_events(Trace *trace, Trace_Event *events, int count)
+{
+    for (int i = 0; i < count; i += 1)
+    {
+        Trace_Event *event = &events[i];
+        fprintf(trace->file, "%s\n", trace->first ? "" : ",");
+        trace->first = false;
+
+        if (event->kind == 'M')
+        {
+            fprintf(trace->file, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %lu, \"args\": {\"name\": \"%s\"}}",
+                (unsigned long)event->thread, event->name);
+            continue;
+        }
+
+        double start = (double)(event->start - trace->origin) * 1000000 / trace->frequency;
+        double duration = (double)(event->end - event->start) * 1000000 / trace->frequency;
+        fprintf(trace->file, "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %lu, \"ts\": %.3f, \"dur\": %.3f, \"args\": {",
+            event->name, event->category, (unsigned long)event->thread, start, duration);
+        if (event->number >= 0) fprintf(trace->file, "\"n\": %d", event->number);
+        if (event->node_count >= 0) fprintf(trace->file, "%s\"nodes\": %d", event->number >= 0 ? ", " : "", event->node_count);
+        fprintf(trace->file, "}}");
+    }
+}
+
+int trace_writer(void *data)
+{
+    Trace *trace = data;
+
+    for (;;)
+    {
+        SDL_SemWaitTimeout(trace->wake, 100);
+        bool quitting = SDL_AtomicGet(&trace->quit);
+
+        // Take everything added so far, leaving the other buffer to fill.
+        SDL_LockMutex(trace->lock);
+        Trace_Event *events = trace->filling;
+        int count = trace->filling_count;
+        trace->filling = trace->writing;
+        trace->filling_count = 0;
+        trace->writing = events;
+        SDL_UnlockMutex(trace->lock);
+
+        trace_write_events(trace, events, count);
+        if (ferror(trace->file)) trace->failed = true;
+
+        if (quitting) break;
+    }
+
+    return 0;
+}
+
+bool trace_start(Trace *trace, const char *path)
+{
+    memset(trace, 0, sizeof(Trace));
+
+    trace->file = fopen(path, "wb");
+    if (!trace->file) return false;
+
+    fprintf(trace->file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    trace->first = true;
+    trace->origin = SDL_GetPerformanceCounter();
+    trace->frequency = SDL_GetPerformanceFrequency();
+
+    trace->filling = memory_alloc(MEMORY_SCRATCH, sizeof(Trace_Event) * TRACE_BUFFER_EVENTS);
+    trace->writing = memory_alloc(MEMORY_SCRATCH, sizeof(Trace_Event) * TRACE_BUFFER_EVENTS);
+    trace->lock = SDL_CreateMutex();
+    trace->wake = SDL_CreateSemaphore(0);
+    trace->thread = SDL_CreateThread(trace_writer, "trace", trace);
+
+    return true;
+}
+
+// Write out everything that's been added and close the file. Returns false if anything went wrong.
+bool trace_finish(Trace *trace)
+{
+    SDL_AtomicSet(&trace->quit, 1);
+    SDL_SemPost(trace->wake);
+    SDL_WaitThread(trace->thread, NULL);
+
+    fprintf(trace->file, "\n]}\n");
+    bool ok = !trace->failed && !ferror(trace->file);
+    if (fclose(trace->file) != 0) ok = false;
+
+    SDL_DestroySemaphore(trace->wake);
+    SDL_DestroyMutex(trace->lock);
+    memory_free(MEMORY_SCRATCH, trace->filling, sizeof(Trace_Event) * TRACE_BUFFER_EVENTS);
+    memory_free(MEMORY_SCRATCH, trace->writing, sizeof(Trace_Event) * TRACE_BUFFER_EVENTS);
+
+    return ok;
+}